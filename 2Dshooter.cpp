@@ -2,6 +2,33 @@
 // 2D Bubble Shooter using classic raster algorithms (DDA, Bresenham, Midpoint Circle).
 // Uses GLFW and fixed-function OpenGL (glBegin/glVertex).
 // Build: link with glfw and OpenGL (opengl32.lib on Windows or -lGL on Linux).
+// Run: 2Dshooter [--framebuffer | --points] [--brute-force] [--validate-collisions] [--max-bubbles N]
+//                 [--single-thread] [--sim-hz H] [--sprite-cache-kb K] [--full-redraw] [--show-dirty]
+//                 [--render-threads N] [--aim-width W] [--profile] [--trace FILE] [--seed N] [--record FILE]
+//                 [--replay FILE [--replay-render]]
+//   --framebuffer (default) rasterizes into a CPU pixel buffer uploaded once per frame
+//   --points      sends every pixel as an immediate-mode GL_POINTS vertex (original path)
+//   --brute-force tests every projectile against every bubble instead of using the grid
+//   --validate-collisions runs both collision passes and reports any disagreement
+//   --max-bubbles raises the bubble cap (default 14) for stress runs
+//   --single-thread runs simulation and rendering back to back on the main thread
+//   --sim-hz      rate of the simulation thread (default 120); rendering runs as fast as it can
+//   --sprite-cache-kb memory ceiling of the framebuffer backend's bubble sprite cache
+//                 (default 16384, 0 rasterizes every bubble every frame)
+//   --full-redraw repaints the whole framebuffer every frame instead of only the dirty regions
+//   --show-dirty  outlines the regions the framebuffer backend redrew each frame
+//   --render-threads N rasterizes the framebuffer in 128x128 tiles on N threads (0 = one per
+//                 core; default 1 draws on the render thread alone). Recording and binning
+//                 the frame cost 1.2-1.9x the single-threaded draw on one core (game_bench
+//                 --suite tiles), so this can only pay off with several free cores, and its
+//                 multi-core scaling has not been measured yet
+//   --aim-width W draws the aim line's dashes as W px thick lines (default 1: one-pixel DDA dashes)
+//   --profile     times every simulation and render stage and prints p50/p95/p99 per stage at exit
+//   --trace FILE  also writes the stage timings as a Chrome trace-event JSON file at exit
+//   --seed N      seed of the random streams (default: the current time; printed at startup)
+//   --record FILE writes the seed, options and every input the simulation consumed to FILE
+//   --replay FILE replays a recording headless as fast as possible and reports simulated FPS;
+//                 --replay-render also rasterizes every step into the CPU framebuffer
 
 #include <GLFW/glfw3.h>
 #include <algorithm>
@@ -10,6 +37,22 @@
 #include <iostream>
 #include <cstdlib>
 #include <ctime>
+#include <cstring>
+#include <chrono>
+#include <atomic>
+#include <thread>
+
+#include "bubble_store.h"
+#include "collision_grid.h"
+#include "dirty_rects.h"
+#include "framebuffer.h"
+#include "profiler.h"
+#include "raster.h"
+#include "replay.h"
+#include "sprite_cache.h"
+#include "static_layers.h"
+#include "tile_renderer.h"
+#include "triple_buffer.h"
 
 using namespace std;
 
@@ -17,15 +60,6 @@ using namespace std;
 int SCR_W = 900;
 int SCR_H = 700;
 
-struct Color { float r, g, b; };
-struct Bubble {
-    float x, y;      // screen coordinates (center)
-    float z;        // pseudo-depth 0..1 (0 near, 1 far)
-    float radius;   // base radius in pixels (before depth)
-    float vx, vy;   // velocity in screen coords
-    Color col;
-    bool alive;
-};
 struct Projectile {
     float x, y;
     float vx, vy;
@@ -40,114 +74,266 @@ float clampf(float a, float b, float v) { return v < a ? a : (v > b ? b : v); }
 // We will draw into orthographic screen coordinates matching window pixels:
 // origin (0,0) bottom-left. We'll map we will use glVertex2i with integer coords.
 
-// Set an integer pixel (draw as GL_POINT)
+// ----- Render backend -----
+// GLPoints: every pixel is an immediate-mode glVertex2i inside glBegin(GL_POINTS).
+// Framebuffer: pixels are written into a packed RGBA buffer that is uploaded as a
+// single texture and drawn as one screen-sized quad at the end of the frame.
+enum class RenderBackend { GLPoints, Framebuffer };
+RenderBackend backend = RenderBackend::Framebuffer;
+
+Framebuffer frame;
+uint32_t penColor = 0xffffffffu; // current color for the framebuffer backend
+GLuint frameTexture = 0;
+
+// Set the current drawing color (glColor3f equivalent for both backends)
+void setColor(float r, float g, float b) {
+    if (backend == RenderBackend::GLPoints) glColor3f(r, g, b);
+    else penColor = packRGBA(r, g, b);
+}
+
+// Bracket a batch of drawPixel calls (glBegin/glEnd for the GL_POINTS backend)
+void beginPixels() {
+    if (backend == RenderBackend::GLPoints) glBegin(GL_POINTS);
+}
+
+void endPixels() {
+    if (backend == RenderBackend::GLPoints) glEnd();
+}
+
+// Run a raster kernel against the active backend. The lambda is instantiated once per
+// sink type, so inside each kernel the per-pixel call is a direct, inlinable call.
+template <class DrawFn>
+void withSink(DrawFn&& draw) {
+    if (backend == RenderBackend::GLPoints) draw(raster::GLPointSink{});
+    else draw(raster::FramebufferSink{ frame, penColor });
+}
+
+// Set an integer pixel (GL_POINT vertex or framebuffer write)
 void drawPixel(int x, int y) {
-    glVertex2i(x, y);
+    withSink([&](auto&& sink) { sink.plot(x, y); });
+}
+
+// Clear the render target to the background color
+void clearTarget(float r, float g, float b) {
+    if (backend == RenderBackend::GLPoints) {
+        glClearColor(r, g, b, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+    }
+    else {
+        frame.clear(packRGBA(r, g, b));
+    }
+}
+
+// Texture with the size of a CPU framebuffer, ready for uploadPixels
+GLuint createPixelTexture(int w, int h) {
+    GLuint tex = 0;
+    glGenTextures(1, &tex);
+    glBindTexture(GL_TEXTURE_2D, tex);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return tex;
+}
+
+void uploadPixels(GLuint tex, const Framebuffer& fb) {
+    glBindTexture(GL_TEXTURE_2D, tex);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, fb.width, fb.height, GL_RGBA, GL_UNSIGNED_BYTE, fb.pixels.data());
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+// Upload only the given rectangles of fb (rows are read with the full buffer's stride)
+void uploadPixelRects(GLuint tex, const Framebuffer& fb, const vector<IRect>& rects) {
+    glBindTexture(GL_TEXTURE_2D, tex);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, fb.width);
+    for (const IRect& r : rects)
+        glTexSubImage2D(GL_TEXTURE_2D, 0, r.x0, r.y0, r.x1 - r.x0 + 1, r.y1 - r.y0 + 1,
+            GL_RGBA, GL_UNSIGNED_BYTE, fb.row(r.y0) + r.x0);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+// Draw a texture as a w x h quad at the origin
+void drawTextureQuad(GLuint tex, int w, int h) {
+    glBindTexture(GL_TEXTURE_2D, tex);
+    glEnable(GL_TEXTURE_2D);
+    glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+    glBegin(GL_QUADS);
+    glTexCoord2f(0.0f, 0.0f); glVertex2i(0, 0);
+    glTexCoord2f(1.0f, 0.0f); glVertex2i(w, 0);
+    glTexCoord2f(1.0f, 1.0f); glVertex2i(w, h);
+    glTexCoord2f(0.0f, 1.0f); glVertex2i(0, h);
+    glEnd();
+    glDisable(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+// Allocate the CPU framebuffer and the texture it is uploaded into
+void initFramebufferTarget() {
+    frame.resize(SCR_W, SCR_H);
+    frameTexture = createPixelTexture(frame.width, frame.height);
+}
+
+// Upload the framebuffer (only the given regions when dirty is set) and draw it as a
+// screen-sized textured quad
+void presentFramebuffer(const vector<IRect>* dirty = nullptr) {
+    if (dirty) uploadPixelRects(frameTexture, frame, *dirty);
+    else uploadPixels(frameTexture, frame);
+    drawTextureQuad(frameTexture, frame.width, frame.height);
+}
+
+// The algorithms themselves live in raster.h; these wrappers bind them to the active backend
+// and clip them to its visible area: the framebuffer's clip rectangle (the whole buffer, or
+// the dirty rectangle being redrawn) or the window for GL_POINTS. Pixels outside it are
+// never generated; clipStats counts them.
+raster::ClipStats clipStats;
+uint64_t printClippedPixels = 0; // clipStats.clippedPixels at the last status line
+
+// While a frame is recorded for the tiled renderer (see "Tiled rendering") the wrappers
+// add commands to its tiles instead of drawing
+TileRenderer tiles;
+bool recordingTiles = false;
+
+raster::ClipRect viewportClip() {
+    if (backend == RenderBackend::Framebuffer) return { frame.clipX0, frame.clipY0, frame.clipX1, frame.clipY1 };
+    return { 0, 0, SCR_W - 1, SCR_H - 1 };
 }
 
 // Midpoint circle algorithm (draws circle perimeter) - integer version
 void drawCircleMidpoint(int xc, int yc, int r) {
-    if (r < 0) return;
-    int x = 0;
-    int y = r;
-    int d = 1 - r;
-
-    while (x <= y) {
-        // eight octants
-        drawPixel(xc + x, yc + y);
-        drawPixel(xc - x, yc + y);
-        drawPixel(xc + x, yc - y);
-        drawPixel(xc - x, yc - y);
-        drawPixel(xc + y, yc + x);
-        drawPixel(xc - y, yc + x);
-        drawPixel(xc + y, yc - x);
-        drawPixel(xc - y, yc - x);
-
-        if (d < 0) {
-            d += 2 * x + 3;
-        }
-        else {
-            d += 2 * (x - y) + 5;
-            y--;
-        }
-        x++;
-    }
+    if (recordingTiles) { tiles.circle(xc, yc, r, penColor); return; }
+    withSink([&](auto&& sink) { raster::circleMidpointClipped(sink, viewportClip(), clipStats, xc, yc, r); });
 }
 
-// Fill a circle by drawing concentric circles (cheap classic approach)
+// Filled circle, one span per scanline (exactly the pixels inside the midpoint outline)
 void fillCircleMidpoint(int xc, int yc, int r) {
-    for (int rr = r; rr >= 0; --rr) {
-        drawCircleMidpoint(xc, yc, rr);
-    }
+    if (recordingTiles) { tiles.disc(xc, yc, r, penColor); return; }
+    withSink([&](auto&& sink) { raster::fillCircleMidpointClipped(sink, viewportClip(), clipStats, xc, yc, r); });
 }
 
-// DDA line algorithm
+// DDA line algorithm (32.32 fixed point, see raster.h)
 void drawLineDDA(int x0, int y0, int x1, int y1) {
-    int dx = x1 - x0;
-    int dy = y1 - y0;
-    int steps = abs(dx) > abs(dy) ? abs(dx) : abs(dy);
-    if (steps == 0) {
-        drawPixel(x0, y0);
-        return;
-    }
-    float Xinc = dx / (float)steps;
-    float Yinc = dy / (float)steps;
-    float x = x0;
-    float y = y0;
-    for (int i = 0; i <= steps; ++i) {
-        drawPixel((int)roundf(x), (int)roundf(y));
-        x += Xinc;
-        y += Yinc;
-    }
+    if (recordingTiles) { tiles.lineDDA(x0, y0, x1, y1, penColor); return; }
+    withSink([&](auto&& sink) { raster::lineDDAFixedClipped(sink, viewportClip(), clipStats, x0, y0, x1, y1); });
 }
 
 // Bresenham's line algorithm (int) - general
 void drawLineBresenham(int x0, int y0, int x1, int y1) {
-    int dx = abs(x1 - x0);
-    int dy = abs(y1 - y0);
-    int sx = (x0 < x1) ? 1 : -1;
-    int sy = (y0 < y1) ? 1 : -1;
-    int err = dx - dy;
+    if (recordingTiles) { tiles.lineBresenham(x0, y0, x1, y1, penColor); return; }
+    withSink([&](auto&& sink) { raster::lineBresenhamClipped(sink, viewportClip(), clipStats, x0, y0, x1, y1); });
+}
 
-    while (true) {
-        drawPixel(x0, y0);
-        if (x0 == x1 && y0 == y1) break;
-        int e2 = 2 * err;
-        if (e2 > -dy) { err -= dy; x0 += sx; }
-        if (e2 < dx) { err += dx; y0 += sy; }
-    }
+// Filled axis-aligned rectangle (HUD elements)
+void fillRect(int x0, int y0, int x1, int y1) {
+    if (recordingTiles) { tiles.rect(x0, y0, x1, y1, penColor); return; }
+    withSink([&](auto&& sink) { raster::fillRectClipped(sink, viewportClip(), clipStats, x0, y0, x1, y1); });
+}
+
+// Line width pixels across with the given end caps, one span per row (barrel, wide aim line)
+void drawThickLine(int x0, int y0, int x1, int y1, float width, raster::LineCap cap = raster::LineCap::Butt) {
+    if (recordingTiles) { tiles.thickLine(x0, y0, x1, y1, width, cap, penColor); return; }
+    withSink([&](auto&& sink) { raster::thickLineClipped(sink, viewportClip(), clipStats, x0, y0, x1, y1, width, cap); });
+}
+
+// ----- Static background layer -----
+// Background color and everything registered with staticLayer (the grid, see
+// registerStaticDecorations) are rasterized once into a cached layer (static_layers.h) and
+// rebuilt only on a theme change or a new screen size. The framebuffer backend copies the
+// layer in place of clearing; the GL_POINTS backend uploads it to a texture when it
+// changes and draws that instead of glClear. T cycles the themes.
+struct Theme {
+    const char* name;
+    Color background;
+    Color grid;
+};
+const Theme THEMES[] = {
+    { "night", { 0.06f, 0.08f, 0.12f }, { 0.08f, 0.1f, 0.15f } },
+    { "blueprint", { 0.05f, 0.13f, 0.28f }, { 0.16f, 0.3f, 0.52f } },
+};
+const int THEME_COUNT = sizeof(THEMES) / sizeof(THEMES[0]);
+int themeIndex = 0;
+
+StaticLayer staticLayer;
+GLuint staticTexture = 0;
+int staticTextureW = 0, staticTextureH = 0;
+
+void applyTheme() {
+    const Color& bg = THEMES[themeIndex].background;
+    staticLayer.setBackground(packRGBA(bg.r, bg.g, bg.b));
+    staticLayer.invalidate(); // decorations read the theme too
 }
 
-// Helper to draw thicker pixel by drawing small cross of points
-void drawThickPixel(int x, int y, int thickness = 2) {
-    for (int ox = -thickness; ox <= thickness; ++ox)
-        for (int oy = -thickness; oy <= thickness; ++oy)
-            drawPixel(x + ox, y + oy);
+void registerStaticDecorations() {
+    // faint background grid (lines every 60 px; run-slice, so a horizontal one is a single fill)
+    staticLayer.add("grid", 0, [](Framebuffer& fb) {
+        const Color& c = THEMES[themeIndex].grid;
+        raster::FramebufferSink sink{ fb, packRGBA(c.r, c.g, c.b) };
+        for (int gx = 0; gx <= fb.width; gx += 60) raster::lineRunSlice(sink, gx, 0, gx, fb.height);
+        for (int gy = 0; gy <= fb.height; gy += 60) raster::lineRunSlice(sink, 0, gy, fb.width, gy);
+    });
+}
+
+// Start the frame with the cached static layer (replaces clearing the target)
+void drawStaticLayer() {
+    staticLayer.resize(SCR_W, SCR_H);
+    bool changed = staticLayer.update();
+    if (backend == RenderBackend::Framebuffer) {
+        staticLayer.composite(frame);
+        return;
+    }
+    const Framebuffer& layer = staticLayer.pixels;
+    if (staticTextureW != layer.width || staticTextureH != layer.height) {
+        if (staticTexture) glDeleteTextures(1, &staticTexture);
+        staticTexture = createPixelTexture(layer.width, layer.height);
+        staticTextureW = layer.width;
+        staticTextureH = layer.height;
+        changed = true;
+    }
+    if (changed) uploadPixels(staticTexture, layer);
+    drawTextureQuad(staticTexture, layer.width, layer.height);
 }
 
 // ----- Game state -----
-vector<Bubble> bubbles;
-vector<Projectile> projectiles;
+// Both stores are fixed-capacity pools (entity_pool.h): spawns and despawns requested
+// during a frame are applied at the start of the next one by applyCommands().
+BubbleStore bubbles; // structure-of-arrays, see bubble_store.h
+EntityPool<Projectile> projectiles;
+const int MAX_PROJECTILES = 256;
+vector<int> drawOrder; // bubble draw order, reused every frame
 
 double lastTime = 0.0;
 int score = 0;
 
+// Random streams, one per subsystem, all derived from the run seed (replay.h)
+uint64_t runSeed = 0;
+Rng spawnRng; // new bubbles and when they appear
+Rng splitRng; // bubbles split off popped ones
+
+void seedRandomStreams(uint64_t seed) {
+    runSeed = seed;
+    spawnRng.reseed(seed, "spawn");
+    splitRng.reseed(seed, "split");
+}
+
 // spawn a bubble with pseudo-depth and random color + velocity
 void spawnBubble() {
     Bubble b;
     // spawn in upper half at random X
-    b.x = rand() % (SCR_W - 120) + 60;
-    b.y = rand() % (SCR_H / 2) + SCR_H / 2;
-    b.z = ((float)(rand() % 100)) / 200.0f; // near 0 to 0.5
-    b.radius = rand() % 18 + 18; // base radius
+    b.x = spawnRng.below(SCR_W - 120) + 60;
+    b.y = spawnRng.below(SCR_H / 2) + SCR_H / 2;
+    b.z = ((float)spawnRng.below(100)) / 200.0f; // near 0 to 0.5
+    b.radius = spawnRng.below(18) + 18; // base radius
     // velocity small (bubbles drift)
-    b.vx = (rand() % 100 - 50) / 100.0f; // -0.5 .. 0.5
-    b.vy = -(rand() % 50 + 10) / 100.0f; // downward drift
-    b.col.r = 0.4f + (rand() % 60) / 150.0f;
-    b.col.g = 0.4f + (rand() % 60) / 150.0f;
-    b.col.b = 0.4f + (rand() % 60) / 150.0f;
+    b.vx = (spawnRng.below(100) - 50) / 100.0f; // -0.5 .. 0.5
+    b.vy = -(spawnRng.below(50) + 10) / 100.0f; // downward drift
+    b.col.r = 0.4f + spawnRng.below(60) / 150.0f;
+    b.col.g = 0.4f + spawnRng.below(60) / 150.0f;
+    b.col.b = 0.4f + spawnRng.below(60) / 150.0f;
     b.alive = true;
-    bubbles.push_back(b);
+    bubbles.spawn(b);
 }
 
 // shoot projectile from (gunX,gunY) toward target; speed constant
@@ -163,13 +349,14 @@ void shootProjectile(float x, float y, float tx, float ty) {
     p.vy = dy / len * speed;
     p.life = 3.0f;
     p.alive = true;
-    projectiles.push_back(p);
+    projectiles.spawn(p);
 }
 
 // ----- Input state -----
-double mouseX = SCR_W / 2.0, mouseY = SCR_H / 2.0;
-bool mouseMoved = false;
-bool fireRequested = false;
+// Written by the GLFW callbacks on the main thread, read by the simulation thread
+atomic<double> mouseX{ SCR_W / 2.0 }, mouseY{ SCR_H / 2.0 };
+atomic<bool> mouseMoved{ false };
+atomic<bool> fireRequested{ false };
 
 // GLFW callbacks
 void cursor_pos_callback(GLFWwindow* window, double xpos, double ypos) {
@@ -182,6 +369,10 @@ void cursor_pos_callback(GLFWwindow* window, double xpos, double ypos) {
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods) {
     if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS) glfwSetWindowShouldClose(window, true);
     if (key == GLFW_KEY_SPACE && action == GLFW_PRESS) fireRequested = true;
+    if (key == GLFW_KEY_T && action == GLFW_PRESS) {
+        themeIndex = (themeIndex + 1) % THEME_COUNT;
+        applyTheme();
+    }
 }
 
 // ----- Collision helper -----
@@ -192,94 +383,735 @@ bool circleCollision(float x1, float y1, float r1, float x2, float y2, float r2)
     return d2 <= rsum * rsum;
 }
 
+// ----- Projectile <-> bubble collision pass -----
+// Grid: bubbles are binned into a uniform screen grid once per frame and each projectile
+// only tests the bubbles in the cells its circle overlaps.
+// BruteForce: every projectile against every bubble (original pass, kept for validation).
+// Both return the lowest-index bubble that is hit, so the outcome is identical.
+enum class Broadphase { Grid, BruteForce };
+Broadphase broadphase = Broadphase::Grid;
+bool validateCollisions = false;
+int maxBubbles = 14;
+
+const float PROJECTILE_RADIUS = 4.0f;
+UniformGrid bubbleGrid;
+long long collisionMismatches = 0;
+double collisionMicros = 0.0; // time of the last collision pass
+
+// effective radius of bubble i with depth
+float bubbleRadius(int i) {
+    float depthScale = 1.0f - clampf(0.0f, 0.8f, bubbles.z[i]);
+    return bubbles.radius[i] * depthScale;
+}
+
+bool bubbleHit(const Projectile& p, int i) {
+    return bubbles.alive[i] && circleCollision(p.x, p.y, PROJECTILE_RADIUS, bubbles.x[i], bubbles.y[i], bubbleRadius(i));
+}
+
+void gridInsertBubble(int i) {
+    float r = bubbleRadius(i);
+    bubbleGrid.insert(i, bubbles.x[i] - r, bubbles.y[i] - r, bubbles.x[i] + r, bubbles.y[i] + r);
+}
+
+void rebuildBubbleGrid() {
+    bubbleGrid.clear();
+    for (int i = 0; i < bubbles.slotCount(); ++i)
+        if (bubbles.alive[i]) gridInsertBubble(i);
+}
+
+// index of the first alive bubble hit by p, or -1
+int findHitBruteForce(const Projectile& p) {
+    for (int i = 0; i < bubbles.slotCount(); ++i)
+        if (bubbleHit(p, i)) return i;
+    return -1;
+}
+
+int findHitGrid(const Projectile& p) {
+    int hit = -1;
+    const float r = PROJECTILE_RADIUS;
+    bubbleGrid.query(p.x - r, p.y - r, p.x + r, p.y + r, [&](int i) {
+        if (hit != -1 && i >= hit) return;
+        if (bubbleHit(p, i)) hit = i;
+    });
+    return hit;
+}
+
+// pop bubble bi with projectile pi; split bubbles are queued and join the game at the
+// next frame boundary, so the stores never change while the pass iterates them
+void popBubble(int pi, int bi) {
+    projectiles[pi].alive = false;
+    projectiles.despawn(projectiles.handle(pi));
+    bubbles.despawn(bi);
+    score += 10;
+    const Bubble b = bubbles.get(bi);
+    // sometimes spawn two smaller bubbles near the popped one
+    if (b.radius > 14 && splitRng.below(100) < 50) {
+        for (int k = 0; k < 2; k++) {
+            Bubble nb;
+            nb.x = b.x + (splitRng.below(40) - 20);
+            nb.y = b.y + (splitRng.below(40) - 20);
+            nb.z = b.z + 0.05f * splitRng.below(3);
+            nb.radius = b.radius * 0.6f;
+            nb.vx = (splitRng.below(100) - 50) / 120.0f;
+            nb.vy = splitRng.below(50) / 120.0f;
+            nb.col = b.col;
+            nb.alive = true;
+            bubbles.spawn(nb);
+        }
+    }
+}
+
+void resolveCollisions() {
+    auto t0 = chrono::steady_clock::now();
+    if (broadphase == Broadphase::Grid) rebuildBubbleGrid();
+    projectiles.forEach([](Projectile& p, int pi) {
+        if (!p.alive) return;
+        int hit = broadphase == Broadphase::Grid ? findHitGrid(p) : findHitBruteForce(p);
+        if (validateCollisions) {
+            int other = broadphase == Broadphase::Grid ? findHitBruteForce(p) : findHitGrid(p);
+            if (other != hit) {
+                ++collisionMismatches;
+                cerr << "\ncollision mismatch: grid/brute-force disagree (" << hit << " vs " << other << ")\n";
+            }
+        }
+        if (hit >= 0) popBubble(pi, hit);
+    });
+    collisionMicros = chrono::duration<double, micro>(chrono::steady_clock::now() - t0).count();
+}
+
 // ----- Rendering procedures using the algorithms -----
-// We will draw with GL_POINTS inside GL_BEGIN/GL_END, and use glVertex2i via our drawPixel wrapper.
-// We need to call glBegin(GL_POINTS) then call algorithm functions which call drawPixel() -> glVertex2i.
-// To set color we call glColor3f before glBegin.
+// Drawing goes through beginPixels()/endPixels() and the drawPixel wrapper, so the same
+// algorithm code feeds either GL_POINTS (glVertex2i) or the CPU framebuffer.
+// To set color we call setColor before beginPixels.
 
-void drawBubbleClassic(const Bubble& b) {
-    // compute screen radius with pseudo depth (farther means smaller)
+// Framebuffer backend: bubbles are blitted from per-radius sprite masks tinted with the
+// bubble's colors (sprite_cache.h)
+bool useSpriteCache = true;
+BubbleSpriteCache spriteCache;
+
+// screen center and radius of a bubble (pseudo depth: farther means smaller)
+void bubbleScreenCircle(const Bubble& b, int& xc, int& yc, int& r) {
     float depthScale = 1.0f - clampf(0.0f, 0.8f, b.z);
-    int r = (int)roundf(b.radius * depthScale);
-    int xc = (int)roundf(b.x);
-    int yc = (int)roundf(b.y);
-    // draw filled bubble by concentric circles (edge rendered by midpoint)
-    glColor3f(b.col.r, b.col.g, b.col.b);
-    glBegin(GL_POINTS);
+    r = (int)roundf(b.radius * depthScale);
+    xc = (int)roundf(b.x);
+    yc = (int)roundf(b.y);
+}
+
+BubblePalette bubblePalette(const Bubble& b) {
+    return { {
+        packRGBA(b.col.r, b.col.g, b.col.b),
+        packRGBA(1.0f, 1.0f, 1.0f),
+        packRGBA(max(0.0f, b.col.r - 0.18f), max(0.0f, b.col.g - 0.18f), max(0.0f, b.col.b - 0.18f)) } };
+}
+
+void drawBubbleClassic(const Bubble& b) {
+    int xc, yc, r;
+    bubbleScreenCircle(b, xc, yc, r);
+    if (backend == RenderBackend::Framebuffer && useSpriteCache) {
+        if (recordingTiles) tiles.sprite(spriteCache.get(r), xc, yc, bubblePalette(b));
+        else blitSprite(frame, spriteCache.get(r), xc, yc, bubblePalette(b));
+        return;
+    }
+    // draw filled bubble with scanline spans (edge rendered by midpoint)
+    setColor(b.col.r, b.col.g, b.col.b);
+    beginPixels();
     fillCircleMidpoint(xc, yc, r);
-    glEnd();
+    endPixels();
     // draw shiny highlight (small white circle at top-left)
     int hx = xc - r / 3;
     int hy = yc + r / 3;
-    glColor3f(1.0f, 1.0f, 1.0f);
-    glBegin(GL_POINTS);
+    setColor(1.0f, 1.0f, 1.0f);
+    beginPixels();
     fillCircleMidpoint(hx, hy, max(1, r / 6));
-    glEnd();
+    endPixels();
     // draw outline (slightly darker)
-    glColor3f(max(0.0f, b.col.r - 0.18f), max(0.0f, b.col.g - 0.18f), max(0.0f, b.col.b - 0.18f));
-    glBegin(GL_POINTS);
+    setColor(max(0.0f, b.col.r - 0.18f), max(0.0f, b.col.g - 0.18f), max(0.0f, b.col.b - 0.18f));
+    beginPixels();
     drawCircleMidpoint(xc, yc, r);
-    glEnd();
+    endPixels();
 }
 
 void drawProjectileClassic(const Projectile& p) {
     // draw projectile as small filled circle
-    glColor3f(1.0f, 0.9f, 0.6f);
-    glBegin(GL_POINTS);
+    setColor(1.0f, 0.9f, 0.6f);
+    beginPixels();
     fillCircleMidpoint((int)roundf(p.x), (int)roundf(p.y), 3);
-    glEnd();
+    endPixels();
 }
 
-void drawLauncherClassic(int baseX, int baseY, int aimX, int aimY) {
-    // draw a small base circle
-    glColor3f(0.2f, 0.2f, 0.25f);
-    glBegin(GL_POINTS);
-    fillCircleMidpoint(baseX, baseY, 10);
-    glEnd();
+const float BARREL_WIDTH = 3.0f;
+int aimWidth = 1; // --aim-width; 1 keeps the one-pixel dashed DDA line
 
-    // draw barrel using Bresenham (thicker)
-    glColor3f(0.85f, 0.85f, 0.9f);
-    glBegin(GL_POINTS);
-    // compute barrel end a bit ahead of aim direction
+// end of the 40 px launcher barrel pointing from the base toward the aim point
+void barrelEnd(int baseX, int baseY, int aimX, int aimY, int& ex, int& ey) {
     float dx = aimX - baseX;
     float dy = aimY - baseY;
     float len = sqrtf(dx * dx + dy * dy);
     if (len < 1e-6f) len = 1;
-    float bx = baseX + dx / len * 40.0f;
-    float by = baseY + dy / len * 40.0f;
-    drawLineBresenham(baseX, baseY, (int)roundf(bx), (int)roundf(by));
-    // thicken barrel by drawing nearby parallel lines
-    drawLineBresenham(baseX - 1, baseY, (int)roundf(bx) - 1, (int)roundf(by));
-    drawLineBresenham(baseX + 1, baseY, (int)roundf(bx) + 1, (int)roundf(by));
-    glEnd();
+    ex = (int)roundf(baseX + dx / len * 40.0f);
+    ey = (int)roundf(baseY + dy / len * 40.0f);
+}
+
+void drawLauncherClassic(int baseX, int baseY, int aimX, int aimY) {
+    // draw a small base circle
+    setColor(0.2f, 0.2f, 0.25f);
+    beginPixels();
+    fillCircleMidpoint(baseX, baseY, 10);
+    endPixels();
+
+    // draw barrel as a 3 px thick line
+    setColor(0.85f, 0.85f, 0.9f);
+    beginPixels();
+    // compute barrel end a bit ahead of aim direction
+    int bx, by;
+    barrelEnd(baseX, baseY, aimX, aimY, bx, by);
+    drawThickLine(baseX, baseY, bx, by, BARREL_WIDTH);
+    endPixels();
 }
 
 void drawAimingDDA(int x0, int y0, int x1, int y1) {
     // draw dashed aim line with DDA
-    glColor3f(0.9f, 0.6f, 0.2f);
+    setColor(0.9f, 0.6f, 0.2f);
     // we will draw short segments every few pixels to create dashed style
-    int dx = x1 - x0, dy = y1 - y0;
-    int steps = abs(dx) > abs(dy) ? abs(dx) : abs(dy);
-    if (steps == 0) return;
-    float Xinc = dx / (float)steps;
-    float Yinc = dy / (float)steps;
-    float x = x0, y = y0;
-    bool drawSeg = true;
     int dashLen = 8;
-    int cnt = 0;
-    glBegin(GL_POINTS);
-    for (int i = 0; i <= steps; i++) {
-        if (drawSeg) drawPixel((int)roundf(x), (int)roundf(y));
-        cnt++;
-        if (cnt >= dashLen) { drawSeg = !drawSeg; cnt = 0; }
-        x += Xinc; y += Yinc;
+    beginPixels();
+    if (aimWidth > 1) {
+        // same dashes as the DDA's (dashLen steps along the major axis, then a gap), each
+        // drawn as a thick line between DDA pixels; the butt end sits one step past the
+        // dash's last pixel
+        raster::DDAFixed line(x0, y0, x1, y1);
+        for (long long k = 0; k <= line.steps; k += 2 * dashLen) {
+            long long end = min(k + dashLen, line.steps + 1);
+            drawThickLine(line.xAt(k), line.yAt(k), line.xAt(end), line.yAt(end), (float)aimWidth);
+        }
     }
-    glEnd();
+    else if (recordingTiles) tiles.dashedLineDDA(x0, y0, x1, y1, dashLen, penColor);
+    else withSink([&](auto&& sink) { raster::dashedLineDDAFixedClipped(sink, viewportClip(), clipStats, x0, y0, x1, y1, dashLen); });
+    endPixels();
+}
+
+// ----- Profiling -----
+// Stage timers (profiler.h); disabled unless --profile or --trace is given. Simulation
+// stages are closed once per step on the simulation thread, render stages once per
+// rendered frame on the main thread.
+enum Stage {
+    // simulation
+    STAGE_INPUT, STAGE_SPAWN, STAGE_UPDATE, STAGE_COLLISION, STAGE_SORT, STAGE_PUBLISH,
+    // render
+    STAGE_DIRTY, STAGE_BACKGROUND, STAGE_BUBBLES, STAGE_PROJECTILES, STAGE_OVERLAY, STAGE_TILES,
+    STAGE_PRESENT, STAGE_SWAP, STAGE_EVENTS,
+    STAGE_COUNT
+};
+const char* const STAGE_NAMES[STAGE_COUNT] = {
+    "sim.input", "sim.spawn", "sim.update", "sim.collision", "sim.sort", "sim.publish",
+    "render.dirty", "render.background", "render.bubbles", "render.projectiles", "render.overlay",
+    "render.tiles", "render.present", "render.swap", "render.events",
+};
+FrameProfiler profiler;
+const char* tracePath = nullptr;
+
+// ----- Record / replay -----
+// With --record the simulation writes everything it consumes to a replay file (replay.h):
+// the seed and options, each fire request with the cursor position it aimed at, and the dt
+// of every step. --replay feeds that file back headless, so a recorded session becomes a
+// reproducible workload (see runReplay).
+InputRecorder recorder;
+chrono::steady_clock::time_point recordStart;
+const char* recordPath = nullptr;
+const char* replayPath = nullptr;
+bool replayRender = false;
+uint64_t simFrames = 0; // steps simulated so far
+
+// called on the simulation thread only
+void recordInput(char type, double a = 0.0, double b = 0.0) {
+    if (!recorder.active()) return;
+    recorder.event(simFrames, chrono::duration<double>(chrono::steady_clock::now() - recordStart).count(), type, a, b);
+}
+
+// hash of the whole simulation state, to check a replay reproduced the recorded run
+uint64_t simulationChecksum() {
+    StateHash h;
+    h.add((uint64_t)score);
+    for (int i = 0; i < bubbles.slotCount(); ++i) {
+        if (!bubbles.alive[i]) continue;
+        h.add(bubbles.x[i]);
+        h.add(bubbles.y[i]);
+        h.add(bubbles.z[i]);
+        h.add(bubbles.radius[i]);
+    }
+    projectiles.forEach([&](Projectile& p, int) {
+        if (!p.alive) return;
+        h.add(p.x);
+        h.add(p.y);
+    });
+    return h.h;
+}
+
+// ----- Simulation / render split -----
+// The simulation (input, spawning, update, collisions) runs on its own thread at a fixed
+// rate and publishes an immutable FrameSnapshot through a triple buffer; the main thread
+// owns the GL context and draws whichever snapshot is newest. A slow render frame no longer
+// stretches the physics step, and a slow physics step only leaves the renderer redrawing
+// the previous snapshot. With --single-thread both run back to back as before.
+
+// Everything the renderer needs from one simulation step
+struct FrameSnapshot {
+    vector<Bubble> bubbles;         // alive bubbles in draw order (farthest first)
+    vector<Projectile> projectiles; // alive projectiles
+    int score = 0;
+    double collisionMicros = 0.0;
+    double simMicros = 0.0; // cost of the step that produced this snapshot
+    uint64_t simFrame = 0;  // steps simulated so far
+};
+
+TripleBuffer<FrameSnapshot> snapshots;
+bool singleThread = false;
+double simHz = 120.0;
+atomic<bool> simRunning{ false };
+
+// Gun base position (bottom center)
+int gunX = SCR_W / 2;
+int gunY = 60;
+// bubbles bounce 30 px from the side walls and die 50 px below the screen
+BubbleBounds bubbleBounds = { 30.0f, (float)(SCR_W - 30), -50.0f };
+
+void simulateFrame(float dt) {
+    // input: fire
+    {
+        ProfileScope scope(profiler, STAGE_INPUT);
+        if (fireRequested.exchange(false)) {
+            double aimX = mouseX.load(), aimY = mouseY.load();
+            recordInput('f', aimX, aimY);
+            shootProjectile((float)gunX, (float)gunY, (float)aimX, (float)aimY);
+        }
+    }
+
+    {
+        ProfileScope scope(profiler, STAGE_SPAWN);
+        // occasionally spawn new bubbles
+        if (bubbles.liveCount() < maxBubbles && spawnRng.below(100) < 5) spawnBubble();
+
+        // frame boundary: recycle dead slots, commit everything spawned since last frame
+        bubbles.applyCommands();
+        projectiles.applyCommands();
+    }
+
+    {
+        ProfileScope scope(profiler, STAGE_UPDATE);
+        // update bubbles: integrate, bounce off sides, kill below screen (SIMD kernel)
+        updateBubblesSIMD(bubbles, dt, bubbleBounds);
+
+        // update projectiles
+        projectiles.forEach([&](Projectile& p, int pi) {
+            if (!p.alive) return;
+            p.x += p.vx * dt;
+            p.y += p.vy * dt;
+            p.life -= dt;
+            if (p.life <= 0.0f || p.x < -50 || p.x > SCR_W + 50 || p.y < -50 || p.y > SCR_H + 50) {
+                p.alive = false;
+                projectiles.despawn(projectiles.handle(pi));
+            }
+        });
+    }
+
+    // collisions projectile <-> bubble
+    ProfileScope scope(profiler, STAGE_COLLISION);
+    resolveCollisions();
+}
+
+// Copy the drawable state into the producer's slot and hand it over to the renderer.
+// The slot's vectors keep their capacity, so this does not allocate once warmed up.
+void publishSnapshot(double simMicros) {
+    FrameSnapshot& s = snapshots.writeBuffer();
+    {
+        ProfileScope scope(profiler, STAGE_SORT);
+        // sort by z descending (farther z larger) -> draw far first
+        drawOrder.clear();
+        for (int i = 0; i < bubbles.slotCount(); ++i)
+            if (bubbles.alive[i]) drawOrder.push_back(i);
+        // ties broken by slot so the order is the same every frame (dirty-region redraws rely on it)
+        sort(drawOrder.begin(), drawOrder.end(), [&](int a, int b) {
+            return bubbles.z[a] != bubbles.z[b] ? bubbles.z[a] > bubbles.z[b] : a < b;
+        });
+    }
+
+    ProfileScope scope(profiler, STAGE_PUBLISH);
+    s.bubbles.clear();
+    for (int idx : drawOrder) s.bubbles.push_back(bubbles.get(idx));
+
+    s.projectiles.clear();
+    projectiles.forEach([&](Projectile& p, int) { if (p.alive) s.projectiles.push_back(p); });
+
+    s.score = score;
+    s.collisionMicros = collisionMicros;
+    s.simMicros = simMicros;
+    s.simFrame = simFrames;
+    snapshots.publish();
+}
+
+void stepAndPublish(float dt) {
+    auto t0 = chrono::steady_clock::now();
+    simulateFrame(dt);
+    recordInput('s', dt);
+    ++simFrames;
+    publishSnapshot(chrono::duration<double, micro>(chrono::steady_clock::now() - t0).count());
+    profiler.endFrame(STAGE_INPUT, STAGE_PUBLISH);
+}
+
+// Simulation thread body: one step every 1/simHz seconds until simRunning is cleared
+void simulationThread() {
+    using clock = chrono::steady_clock;
+    profiler.nameThread("simulation");
+    const auto period = chrono::duration_cast<clock::duration>(chrono::duration<double>(1.0 / simHz));
+    auto last = clock::now();
+    auto next = last;
+    while (simRunning.load()) {
+        auto now = clock::now();
+        stepAndPublish(chrono::duration<float>(now - last).count());
+        last = now;
+        // after a stall restart the schedule instead of bursting to catch up
+        next += period;
+        if (next < clock::now()) next = clock::now() + period;
+        this_thread::sleep_until(next);
+    }
+}
+
+// ----- Dirty-rectangle redraw -----
+// Framebuffer backend only. The framebuffer keeps the previous frame's pixels; every frame
+// the box and signature of each element (bubble, projectile, launcher, aim line, HUD) are
+// collected, the old boxes of elements that moved, changed or disappeared and the new boxes
+// of elements that appeared are marked dirty (dirty_rects.h), and only those regions are
+// restored from the static layer and re-rasterized, with the framebuffer clipped to each
+// region and only the elements overlapping it drawn, in the usual order. Only the dirty
+// regions are uploaded to the texture. A rebuilt static layer repaints everything.
+const int DIRTY_TILE = 16;
+const double DIRTY_FULL_FRACTION = 0.35; // above this share of tiles one full-screen rect is cheaper
+bool dirtyTracking = true;
+bool showDirty = false;
+DirtyRegion dirtyRegion;
+vector<DrawItem> frameItems;      // this frame's elements in draw order
+vector<DrawItem> sortedItems;     // the same, ordered by signature
+vector<DrawItem> prevSortedItems; // last frame's, ordered by signature
+bool repaintAll = true;           // first frame, or the background changed
+long long dirtyPixels = 0;        // summed since the last status line
+
+// item kinds folded into the signatures
+enum DrawItemKind { ITEM_BUBBLE = 1, ITEM_PROJECTILE, ITEM_LAUNCHER, ITEM_AIM, ITEM_HUD };
+
+const int HUD_X = 12, HUD_Y_FROM_TOP = 20;
+
+// Element boxes and signatures for snapshot s, in the order renderScene draws them
+void collectFrameItems(const FrameSnapshot& s, int aimX, int aimY) {
+    frameItems.clear();
+    for (const Bubble& b : s.bubbles) {
+        int xc, yc, r;
+        bubbleScreenCircle(b, xc, yc, r);
+        BubblePalette p = bubblePalette(b);
+        uint64_t sig = hashMix(hashMix(hashMix(hashMix(ITEM_BUBBLE, (uint32_t)xc), (uint32_t)yc), (uint32_t)r),
+            ((uint64_t)p.layer[BubblePalette::FILL] << 32) | p.layer[BubblePalette::OUTLINE]);
+        // one pixel of margin for the highlight of tiny bubbles (as the sprite extent)
+        int e = max(r, 0) + 1;
+        frameItems.push_back({ { xc - e, yc - e, xc + e, yc + e }, sig });
+    }
+    for (const Projectile& p : s.projectiles) {
+        int x = (int)roundf(p.x), y = (int)roundf(p.y);
+        frameItems.push_back({ { x - 3, y - 3, x + 3, y + 3 }, hashMix(hashMix(ITEM_PROJECTILE, (uint32_t)x), (uint32_t)y) });
+    }
+    uint64_t aimSig = hashMix((uint32_t)aimX, (uint32_t)aimY);
+    int bx, by;
+    barrelEnd(gunX, gunY, aimX, aimY, bx, by);
+    // a thick line stays within half its width of the segment (its butt ends do too)
+    int barrel = (int)ceilf(BARREL_WIDTH * 0.5f);
+    frameItems.push_back({ { min(gunX - 10, bx - barrel), min(gunY - 10, by - barrel), max(gunX + 10, bx + barrel), max(gunY + 10, by + barrel) },
+        hashMix(ITEM_LAUNCHER, aimSig) });
+    int aim = aimWidth > 1 ? (aimWidth + 1) / 2 + 1 : 0; // the last wide dash may end a step past the aim point
+    frameItems.push_back({ { min(gunX, aimX) - aim, min(gunY, aimY) - aim, max(gunX, aimX) + aim, max(gunY, aimY) + aim },
+        hashMix(ITEM_AIM, aimSig) });
+    int sy = SCR_H - HUD_Y_FROM_TOP;
+    frameItems.push_back({ { HUD_X, sy - 11, HUD_X + 5, sy }, ITEM_HUD });
+}
+
+// Draw the snapshot's elements over the background; with clip set, only the elements
+// whose frameItems box overlaps it
+void renderScene(const FrameSnapshot& s, int aimX, int aimY, const IRect* clip) {
+    size_t item = 0;
+    auto visible = [&]() { return !clip || frameItems[item++].box.overlaps(*clip); };
+
+    // draw bubbles (farthest first for nicer overlap; the snapshot is already sorted)
+    {
+        ProfileScope scope(profiler, STAGE_BUBBLES);
+        for (const Bubble& b : s.bubbles)
+            if (visible()) drawBubbleClassic(b);
+    }
+
+    // draw projectiles
+    {
+        ProfileScope scope(profiler, STAGE_PROJECTILES);
+        for (const Projectile& p : s.projectiles)
+            if (visible()) drawProjectileClassic(p);
+    }
+
+    ProfileScope overlayScope(profiler, STAGE_OVERLAY);
+    // draw launcher (gun) using Bresenham; barrel aimed at mouse
+    if (visible()) drawLauncherClassic(gunX, gunY, aimX, aimY);
+
+    // draw aiming dashed DDA line (from gun to mouse)
+    if (visible()) drawAimingDDA(gunX, gunY, aimX, aimY);
+
+    // draw HUD text using very simple blocky numbers (we'll draw score as circles/lines)
+    // Instead: draw small score indicator as colored squares on top-left
+    if (visible()) {
+        int sx = HUD_X, sy = SCR_H - HUD_Y_FROM_TOP;
+        setColor(0.9f, 0.9f, 0.2f);
+        beginPixels();
+        fillRect(sx, sy - 11, sx + 5, sy);
+        endPixels();
+    }
+}
+
+// Bring the static layer up to date and compute this frame's dirtyRegion.rects
+void updateDirtyRegion(const FrameSnapshot& s, int aimX, int aimY) {
+    ProfileScope scope(profiler, STAGE_DIRTY);
+    staticLayer.resize(SCR_W, SCR_H);
+    if (staticLayer.update()) repaintAll = true;
+    if (dirtyRegion.width != frame.width || dirtyRegion.height != frame.height) {
+        dirtyRegion.reset(frame.width, frame.height, DIRTY_TILE);
+        repaintAll = true;
+    }
+
+    collectFrameItems(s, aimX, aimY);
+    sortedItems = frameItems;
+    sortBySig(sortedItems);
+    dirtyRegion.clear();
+    if (repaintAll) dirtyRegion.markAll();
+    else dirtyRegion.addChanges(prevSortedItems, sortedItems);
+    repaintAll = false;
+    swap(prevSortedItems, sortedItems);
+    dirtyRegion.build(DIRTY_FULL_FRACTION);
+}
+
+// Redraw only what changed since the previous frame (framebuffer backend)
+void renderDirtyRegions(const FrameSnapshot& s, int aimX, int aimY) {
+    updateDirtyRegion(s, aimX, aimY);
+    for (const IRect& r : dirtyRegion.rects) {
+        frame.setClip(r.x0, r.y0, r.x1, r.y1);
+        {
+            ProfileScope scope(profiler, STAGE_BACKGROUND);
+            staticLayer.composite(frame, r.x0, r.y0, r.x1, r.y1);
+        }
+        renderScene(s, aimX, aimY, &r);
+    }
+    frame.resetClip();
+    dirtyPixels += dirtyRegion.pixels;
+}
+
+// ----- Tiled rendering -----
+// Framebuffer backend with --render-threads N > 1: the frame's primitives are recorded once
+// into the bins of 128x128 screen tiles (tile_renderer.h), then the tiles inside the regions
+// to redraw (the dirty regions, or the whole screen with --full-redraw) are restored from
+// the static layer and rasterized by N threads with work stealing. The output is
+// pixel-identical to the single-threaded paths above. The recording and binning are extra
+// work the serial path does not do, so this is slower than it unless N threads really run
+// in parallel (see --render-threads).
+int renderThreads = 1;
+uint64_t printSteals = 0; // tiles.pool.steals() at the last status line
+
+void renderTiled(const FrameSnapshot& s, int aimX, int aimY) {
+    vector<IRect> fullScreen;
+    const vector<IRect>* regions = &fullScreen;
+    if (dirtyTracking) {
+        updateDirtyRegion(s, aimX, aimY);
+        regions = &dirtyRegion.rects;
+        dirtyPixels += dirtyRegion.pixels;
+    }
+    else {
+        ProfileScope scope(profiler, STAGE_BACKGROUND);
+        staticLayer.resize(SCR_W, SCR_H);
+        staticLayer.update();
+        fullScreen.push_back({ 0, 0, frame.width - 1, frame.height - 1 });
+    }
+
+    // sprites referenced by the recorded commands must survive until they are drawn
+    spriteCache.holdEvictions(true);
+    tiles.begin(frame.width, frame.height);
+    recordingTiles = true;
+    renderScene(s, aimX, aimY, nullptr);
+    recordingTiles = false;
+    {
+        ProfileScope scope(profiler, STAGE_TILES);
+        tiles.render(frame, &staticLayer.pixels, *regions);
+    }
+    spriteCache.holdEvictions(false);
+}
+
+// Debug overlay: outline this frame's dirty regions on top of the presented frame (drawn
+// with GL, so it never ends up in the framebuffer)
+void drawDirtyOverlay() {
+    glColor3f(1.0f, 0.2f, 0.9f);
+    for (const IRect& r : dirtyRegion.rects) {
+        glBegin(GL_LINE_LOOP);
+        glVertex2f(r.x0 + 0.5f, r.y0 + 0.5f);
+        glVertex2f(r.x1 + 0.5f, r.y0 + 0.5f);
+        glVertex2f(r.x1 + 0.5f, r.y1 + 0.5f);
+        glVertex2f(r.x0 + 0.5f, r.y1 + 0.5f);
+        glEnd();
+    }
+}
+
+void renderSnapshot(const FrameSnapshot& s) {
+    // the launcher follows the live cursor rather than the snapshot, so aiming stays responsive
+    int aimX = (int)roundf((float)mouseX.load());
+    int aimY = (int)roundf((float)mouseY.load());
+
+    if (backend == RenderBackend::Framebuffer && renderThreads > 1) {
+        renderTiled(s, aimX, aimY);
+        return;
+    }
+    if (backend == RenderBackend::Framebuffer && dirtyTracking) {
+        renderDirtyRegions(s, aimX, aimY);
+        return;
+    }
+    // background color and grid come from the cached static layer
+    {
+        ProfileScope scope(profiler, STAGE_BACKGROUND);
+        drawStaticLayer();
+    }
+    renderScene(s, aimX, aimY, nullptr);
+}
+
+// Pools, snapshot slots, initial bubbles and the collision grid for a new game
+void initSimulation() {
+    // pools: splits can push the bubble count past the cap, so leave headroom
+    bubbles.reset(maxBubbles * 4 + 64);
+    projectiles.reset(MAX_PROJECTILES);
+    drawOrder.reserve(bubbles.capacity());
+    for (FrameSnapshot& snap : snapshots.slots) {
+        snap.bubbles.reserve(bubbles.capacity());
+        snap.projectiles.reserve(MAX_PROJECTILES);
+    }
+
+    // spawn initial bubbles (stress runs with a raised cap start full)
+    int initialBubbles = maxBubbles > 14 ? maxBubbles : 8;
+    for (int i = 0; i < initialBubbles; i++) spawnBubble();
+    bubbles.applyCommands();
+    // grid cells a bit larger than the biggest bubble keep each bubble in at most 4 cells
+    bubbleGrid.reset((float)SCR_W, (float)SCR_H, 64.0f);
+}
+
+// ----- Headless replay -----
+// --replay FILE runs the recorded steps back to back without a window, on the calling
+// thread, and reports simulated steps per second. With --replay-render every step's
+// snapshot is also rasterized into the CPU framebuffer (never presented). Returns non-zero
+// if the final state differs from the one recorded.
+int runReplay() {
+    ReplayLog log;
+    string error;
+    if (!log.load(replayPath, "2Dshooter", error)) {
+        cerr << "Cannot replay " << replayPath << ": " << error << "\n";
+        return -1;
+    }
+    seedRandomStreams(log.seed);
+    maxBubbles = (int)log.option("max-bubbles", maxBubbles);
+    initSimulation();
+    if (replayRender) {
+        backend = RenderBackend::Framebuffer;
+        frame.resize(SCR_W, SCR_H);
+        registerStaticDecorations();
+        applyTheme();
+    }
+    publishSnapshot(0.0);
+
+    auto t0 = chrono::steady_clock::now();
+    for (const InputEvent& e : log.events) {
+        if (e.type == 'f') {
+            mouseX = e.a;
+            mouseY = e.b;
+            fireRequested = true;
+        }
+        else if (e.type == 's') {
+            stepAndPublish((float)e.a);
+            if (replayRender) {
+                snapshots.acquire();
+                renderSnapshot(snapshots.readBuffer());
+                profiler.endFrame(STAGE_DIRTY, STAGE_EVENTS);
+            }
+        }
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+
+    uint64_t checksum = simulationChecksum();
+    cout << "Replayed " << simFrames << " steps in " << seconds << " s: " << (int)(simFrames / max(seconds, 1e-9))
+         << " simulated FPS" << (replayRender ? " (with software rendering)" : "") << "\n";
+    cout << "Final score " << score << ", state " << hex << checksum << dec << "\n";
+    bool match = true;
+    if (log.hasFinal) {
+        match = log.finalSteps == simFrames && log.finalScore == score && log.finalChecksum == checksum;
+        cout << (match ? "Matches the recording\n" : "DIFFERS from the recording\n");
+    }
+    if (profiler.enabled) {
+        profiler.printReport(stdout);
+        if (tracePath && !profiler.writeTrace(tracePath)) cerr << "Failed to write trace " << tracePath << endl;
+    }
+    return match ? 0 : 1;
 }
 
 // ----- Main -----
-int main() {
-    srand((unsigned)time(nullptr));
+int main(int argc, char** argv) {
+    profiler.setStages(STAGE_NAMES, STAGE_COUNT);
+    bool seedGiven = false;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--points") == 0) backend = RenderBackend::GLPoints;
+        else if (strcmp(argv[i], "--framebuffer") == 0) backend = RenderBackend::Framebuffer;
+        else if (strcmp(argv[i], "--brute-force") == 0) broadphase = Broadphase::BruteForce;
+        else if (strcmp(argv[i], "--validate-collisions") == 0) validateCollisions = true;
+        else if (strcmp(argv[i], "--max-bubbles") == 0 && i + 1 < argc) maxBubbles = max(1, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--single-thread") == 0) singleThread = true;
+        else if (strcmp(argv[i], "--sim-hz") == 0 && i + 1 < argc) simHz = max(1.0, atof(argv[++i]));
+        else if (strcmp(argv[i], "--sprite-cache-kb") == 0 && i + 1 < argc) {
+            int kb = max(0, atoi(argv[++i]));
+            useSpriteCache = kb > 0;
+            spriteCache.setCapacity((size_t)kb * 1024);
+        }
+        else if (strcmp(argv[i], "--full-redraw") == 0) dirtyTracking = false;
+        else if (strcmp(argv[i], "--show-dirty") == 0) showDirty = true;
+        else if (strcmp(argv[i], "--render-threads") == 0 && i + 1 < argc) {
+            renderThreads = atoi(argv[++i]);
+            if (renderThreads <= 0) renderThreads = max(1, (int)thread::hardware_concurrency());
+        }
+        else if (strcmp(argv[i], "--aim-width") == 0 && i + 1 < argc) aimWidth = max(1, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--profile") == 0) profiler.enable(false);
+        else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            tracePath = argv[++i];
+            profiler.enable(true);
+        }
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            runSeed = strtoull(argv[++i], nullptr, 10);
+            seedGiven = true;
+        }
+        else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) recordPath = argv[++i];
+        else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) replayPath = argv[++i];
+        else if (strcmp(argv[i], "--replay-render") == 0) replayRender = true;
+        else {
+            cerr << "Usage: " << argv[0] << " [--framebuffer | --points] [--brute-force] [--validate-collisions] [--max-bubbles N]"
+                 << " [--single-thread] [--sim-hz H] [--sprite-cache-kb K] [--full-redraw] [--show-dirty]"
+                 << " [--render-threads N] [--aim-width W] [--profile] [--trace FILE] [--seed N] [--record FILE] [--replay FILE [--replay-render]]\n";
+            return -1;
+        }
+    }
+
+    tiles.pool.resize(renderThreads);
+    if (replayPath) return runReplay();
+
+    seedRandomStreams(seedGiven ? runSeed : (uint64_t)time(nullptr));
+    if (recordPath) {
+        if (!recorder.open(recordPath, "2Dshooter", runSeed)) {
+            cerr << "Cannot write " << recordPath << "\n";
+            return -1;
+        }
+        recorder.option("max-bubbles", maxBubbles);
+        recorder.beginEvents();
+        recordStart = chrono::steady_clock::now();
+    }
     if (!glfwInit()) {
         cerr << "Failed to init GLFW\n";
         return -1;
@@ -314,143 +1146,109 @@ int main() {
     // set point size to 1
     glPointSize(1.0f);
 
-    // spawn initial bubbles
-    for (int i = 0; i < 8; i++) spawnBubble();
+    if (backend == RenderBackend::Framebuffer) initFramebufferTarget();
+    registerStaticDecorations();
+    applyTheme();
+    cout << "Render backend: " << (backend == RenderBackend::Framebuffer ? "framebuffer" : "GL_POINTS") << "\n";
+    cout << "Seed: " << runSeed << (recordPath ? string(", recording to ") + recordPath : string()) << "\n";
 
-    lastTime = glfwGetTime();
-    cout << "Controls: move mouse to aim, SPACE to shoot, ESC to quit\n";
+    initSimulation();
+
+    cout << "Controls: move mouse to aim, SPACE to shoot, T to change theme, ESC to quit\n";
+    if (singleThread) cout << "Simulation: main thread, once per rendered frame\n";
+    else cout << "Simulation: own thread at " << simHz << " Hz\n";
 
-    // Gun base position (bottom center)
-    int gunX = SCR_W / 2;
-    int gunY = 60;
+    // give the renderer the initial state before the first step
+    publishSnapshot(0.0);
+    profiler.nameThread("render");
+    thread simThread;
+    if (!singleThread) {
+        simRunning = true;
+        simThread = thread(simulationThread);
+    }
+
+    lastTime = glfwGetTime();
+    double tprint = lastTime;
+    uint64_t printSimFrame = 0;
+    int renderFrames = 0;
+    double renderMicros = 0.0;
 
     while (!glfwWindowShouldClose(window)) {
         double now = glfwGetTime();
-        float dt = (float)(now - lastTime);
-        lastTime = now;
-
-        // input: fire
-        if (fireRequested) {
-            shootProjectile((float)gunX, (float)gunY, (float)mouseX, (float)mouseY);
-            fireRequested = false;
+        if (singleThread) {
+            float dt = (float)(now - lastTime);
+            lastTime = now;
+            stepAndPublish(dt);
         }
 
-        // occasionally spawn new bubbles
-        if (bubbles.size() < 14 && (rand() % 100) < 5) spawnBubble();
-
-        // update bubbles
-        for (auto& b : bubbles) {
-            if (!b.alive) continue;
-            b.x += b.vx * dt * 60.0f; // scale velocities visually
-            b.y += b.vy * dt * 60.0f;
-            // bounce off sides
-            if (b.x < 30) { b.x = 30; b.vx = fabs(b.vx); }
-            if (b.x > SCR_W - 30) { b.x = SCR_W - 30; b.vx = -fabs(b.vx); }
-            // remove if below screen
-            if (b.y < -50) b.alive = false;
+        // --- render the newest snapshot (the previous one again if nothing new arrived) ---
+        snapshots.acquire();
+        const FrameSnapshot& snap = snapshots.readBuffer();
+        auto r0 = chrono::steady_clock::now();
+        renderSnapshot(snap);
+        if (backend == RenderBackend::Framebuffer) {
+            ProfileScope scope(profiler, STAGE_PRESENT);
+            presentFramebuffer(dirtyTracking ? &dirtyRegion.rects : nullptr);
+            if (dirtyTracking && showDirty) drawDirtyOverlay();
         }
-        // remove dead bubbles
-        bubbles.erase(remove_if(bubbles.begin(), bubbles.end(), [](const Bubble& bb) { return !bb.alive; }), bubbles.end());
+        renderMicros = chrono::duration<double, micro>(chrono::steady_clock::now() - r0).count();
+        ++renderFrames;
 
-        // update projectiles
-        for (auto& p : projectiles) {
-            if (!p.alive) continue;
-            p.x += p.vx * dt;
-            p.y += p.vy * dt;
-            p.life -= dt;
-            if (p.life <= 0.0f || p.x < -50 || p.x > SCR_W + 50 || p.y < -50 || p.y > SCR_H + 50) p.alive = false;
-        }
-        projectiles.erase(remove_if(projectiles.begin(), projectiles.end(), [](const Projectile& pp) { return !pp.alive; }), projectiles.end());
-
-        // collisions projectile <-> bubble
-        for (auto& p : projectiles) if (p.alive) {
-            for (auto& b : bubbles) if (b.alive) {
-                // compute effective radius with depth
-                float depthScale = 1.0f - clampf(0.0f, 0.8f, b.z);
-                float r = b.radius * depthScale;
-                if (circleCollision(p.x, p.y, 4.0f, b.x, b.y, r)) {
-                    p.alive = false;
-                    b.alive = false;
-                    score += 10;
-                    // sometimes spawn two smaller bubbles near the popped one
-                    if (b.radius > 14 && (rand() % 100) < 50) {
-                        for (int k = 0; k < 2; k++) {
-                            Bubble nb;
-                            nb.x = b.x + (rand() % 40 - 20);
-                            nb.y = b.y + (rand() % 40 - 20);
-                            nb.z = b.z + 0.05f * (rand() % 3);
-                            nb.radius = b.radius * 0.6f;
-                            nb.vx = (rand() % 100 - 50) / 120.0f;
-                            nb.vy = (rand() % 50) / 120.0f;
-                            nb.col = b.col;
-                            nb.alive = true;
-                            bubbles.push_back(nb);
-                        }
-                    }
-                    break;
-                }
+        // simple numeric print to console periodically; each thread's rate and cost
+        if (now - tprint > 0.4) {
+            double span = now - tprint;
+            cout << "\rScore: " << snap.score << "  Bubbles: " << snap.bubbles.size() << "  Projectiles: " << snap.projectiles.size()
+                 << "  Collide: " << (int)snap.collisionMicros << "us"
+                 << "  Sim: " << (int)((snap.simFrame - printSimFrame) / span) << "Hz " << (int)snap.simMicros << "us"
+                 << "  Render: " << (int)(renderFrames / span) << "fps " << (int)renderMicros << "us";
+            if (backend == RenderBackend::Framebuffer && useSpriteCache) {
+                const SpriteCacheStats& cs = spriteCache.stats;
+                cout << "  Sprites: " << (int)(cs.hitRate() * 100.0) << "% hit " << cs.entries << " (" << cs.bytes / 1024 << "KB)";
             }
+            if (backend == RenderBackend::Framebuffer && dirtyTracking && renderFrames > 0) {
+                double touched = 100.0 * dirtyPixels / ((double)renderFrames * frame.width * frame.height);
+                cout << "  Dirty: " << (int)touched << "." << (int)(touched * 10) % 10 << "%";
+            }
+            if (backend == RenderBackend::Framebuffer && renderThreads > 1 && renderFrames > 0)
+                cout << "  Tiles: " << renderThreads << " threads, " << (tiles.pool.steals() - printSteals) / renderFrames << " steals/f";
+            if (renderFrames > 0) cout << "  Clipped: " << (clipStats.clippedPixels - printClippedPixels) / renderFrames << "px/f";
+            cout << "  BG builds: " << staticLayer.rebuilds << "     " << flush;
+            tprint = now;
+            printSimFrame = snap.simFrame;
+            renderFrames = 0;
+            dirtyPixels = 0;
+            printClippedPixels = clipStats.clippedPixels;
+            printSteals = tiles.pool.steals();
         }
 
-        // --- render ---
-        glClearColor(0.06f, 0.08f, 0.12f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT);
-
-        // Draw background grid very faint (using DDA lines)
-        glColor3f(0.08f, 0.1f, 0.15f);
-        // vertical grid lines every 60 px
-        for (int gx = 0; gx <= SCR_W; gx += 60) {
-            glBegin(GL_POINTS); drawLineDDA(gx, 0, gx, SCR_H); glEnd();
-        }
-        // horizontal grid lines
-        for (int gy = 0; gy <= SCR_H; gy += 60) {
-            glBegin(GL_POINTS); drawLineDDA(0, gy, SCR_W, gy); glEnd();
-        }
-
-        // draw bubbles (farthest first for nicer overlap)
-        // sort by z descending (farther z larger) -> draw far first
-        vector<int> order(bubbles.size());
-        for (int i = 0; i < (int)bubbles.size(); ++i) order[i] = i;
-        sort(order.begin(), order.end(), [&](int a, int b) { return bubbles[a].z > bubbles[b].z; });
-
-        for (int idx : order) {
-            drawBubbleClassic(bubbles[idx]);
+        {
+            ProfileScope scope(profiler, STAGE_SWAP);
+            glfwSwapBuffers(window);
         }
-
-        // draw projectiles
-        for (auto& p : projectiles) drawProjectileClassic(p);
-
-        // draw launcher (gun) using Bresenham; barrel aimed at mouse
-        drawLauncherClassic(gunX, gunY, (int)roundf(mouseX), (int)roundf(mouseY));
-
-        // draw aiming dashed DDA line (from gun to mouse)
-        drawAimingDDA(gunX, gunY, (int)roundf(mouseX), (int)roundf(mouseY));
-
-        // draw HUD text using very simple blocky numbers (we'll draw score as circles/lines)
-        // Instead: draw small score indicator as colored squares on top-left
         {
-            int sx = 12, sy = SCR_H - 20;
-            // draw score color bar
-            glColor3f(0.9f, 0.9f, 0.2f);
-            glBegin(GL_POINTS);
-            for (int i = 0; i < 6; i++)
-                for (int j = 0; j < 12; j++)
-                    drawPixel(sx + i, sy - j);
-            glEnd();
-            // simple numeric print to console periodically
-            static double tprint = 0;
-            if (now - tprint > 0.4) {
-                cout << "\rScore: " << score << "  Bubbles: " << bubbles.size() << "  Projectiles: " << projectiles.size() << "     " << flush;
-                tprint = now;
-            }
+            ProfileScope scope(profiler, STAGE_EVENTS);
+            glfwPollEvents();
         }
-
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        profiler.endFrame(STAGE_DIRTY, STAGE_EVENTS);
     }
 
+    simRunning = false;
+    if (simThread.joinable()) simThread.join();
+    recorder.finish(simFrames, score, simulationChecksum());
+
+    if (frameTexture) glDeleteTextures(1, &frameTexture);
+    if (staticTexture) glDeleteTextures(1, &staticTexture);
     glfwDestroyWindow(window);
     glfwTerminate();
     cout << "\nGame closed. Final score: " << score << endl;
+    if (validateCollisions) cout << "Collision mismatches: " << collisionMismatches << endl;
+    if (profiler.enabled) {
+        cout << "\nFrame profile (" << (singleThread ? "one thread" : "simulation and render threads") << "):\n";
+        profiler.printReport(stdout);
+        if (tracePath) {
+            if (profiler.writeTrace(tracePath)) cout << "Trace written to " << tracePath << endl;
+            else cerr << "Failed to write trace " << tracePath << endl;
+        }
+    }
     return 0;
 }
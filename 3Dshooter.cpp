@@ -1,8 +1,38 @@
+// 3D FPS target shooter (GLUT, fixed-function OpenGL).
+// Run: 3Dshooter [--targets N] [--bullet-speed S] [--brute-force] [--sim-hz H] [--render-hz R]
+//                 [--immediate] [--no-cull] [--no-lod] [--bench N] [--profile] [--trace FILE]
+//                 [--seed N] [--record FILE] [--replay FILE]
+//   --targets N       number of targets (default 10; more are spread over the whole field)
+//   --bullet-speed S  bullet speed in units per second (default 30)
+//   --brute-force     test each bullet against every target instead of the grid
+//   --sim-hz H        fixed simulation rate (default 60)
+//   --render-hz R     render rate cap, 0 = as fast as the display allows (default 0)
+//   --immediate       draw with the original per-object glut/GLU calls instead of batched meshes
+//   --no-cull         submit every object instead of frustum culling
+//   --no-lod          draw every bullet at full tessellation (targets have only one)
+//   --bench N         draw N targets and N bullets with both paths, print frame times as JSON, exit
+//                     (for Mesa's software renderer: LIBGL_ALWAYS_SOFTWARE=1 3Dshooter --bench 10000)
+//   --profile         time every input, simulation and render stage; print p50/p95/p99 per stage at exit
+//   --trace FILE      also write the stage timings as a Chrome trace-event JSON file at exit
+//   --seed N          seed of the random streams (default 1)
+//   --record FILE     write the seed, options and every input event (with its simulation step) to FILE
+//   --replay FILE     replay a recording headless, without a window, as fast as possible and
+//                     report simulated steps per second
+
 #include <GL/glut.h>
+#include <chrono>
 #include <cmath>
 #include <vector>
+#include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <string>
+#include <thread>
+
+#include "collision_grid.h"
+#include "mesh_batch.h"
+#include "profiler.h"
+#include "replay.h"
 
 // ================== CAMERA ==================
 float camX = 0.0f, camY = 1.5f, camZ = 5.0f;
@@ -11,10 +41,46 @@ float camYaw = 0.0f, camPitch = 0.0f;
 // ================== BULLET ==================
 struct Bullet {
     float x, y, z;
-    float dx, dy, dz;
+    float px, py, pz;  // position at the previous simulation step (for interpolation)
+    float dx, dy, dz;  // velocity, units per second
     bool active;
+    float life; // seconds left before the bullet expires
+};
+
+// Fixed-capacity bullet pool. Live bullets are packed in slots [0, live), so update and
+// draw touch only bullets in flight; a dead bullet is recycled in O(1) by moving the last
+// live bullet into its slot.
+const int MAX_BULLETS = 1024;
+const float BULLET_LIFE = 4.0f;      // seconds (120 units of travel at the default speed)
+const float WORLD_HALF_EXTENT = 60.0f; // bullets leaving this box (or going below the ground) expire
+
+struct BulletPool {
+    std::vector<Bullet> slots;
+    int live = 0;
+    int peak = 0;
+    long long fired = 0;
+    long long expired = 0;
+    long long dropped = 0; // shots lost because the pool was full
+
+    void reset(int capacity) {
+        slots.assign(capacity, Bullet{});
+        live = peak = 0;
+    }
+
+    void spawn(const Bullet& b) {
+        if (live == (int)slots.size()) { ++dropped; return; }
+        slots[live++] = b;
+        ++fired;
+        if (live > peak) peak = live;
+    }
+
+    // remove slot i; the caller must not advance i, the slot now holds another live bullet
+    void recycle(int i) {
+        slots[i] = slots[--live];
+        ++expired;
+    }
 };
-std::vector<Bullet> bullets;
+BulletPool bullets;
 
 // ================== TARGET ==================
 struct Target {
@@ -22,12 +88,96 @@ struct Target {
     bool alive;
     float spinAngle;
     float r, g, b; // fixed color
+    float prevSpin; // spin at the previous simulation step (for interpolation)
 };
 std::vector<Target> targets;
 
 // ================== SCORE ==================
 int score = 0;
 
+// ================== RANDOM STREAMS ==================
+// One stream per subsystem, all derived from the run seed (replay.h)
+uint64_t runSeed = 1;
+Rng targetRng; // target placement and colors
+Rng benchRng;  // --bench bullet placement
+
+void seedRandomStreams(uint64_t seed) {
+    runSeed = seed;
+    targetRng.reseed(seed, "targets");
+    benchRng.reseed(seed, "bench");
+}
+
+// ================== COLLISION ==================
+// Each update a bullet sweeps the segment from its previous to its new position; the
+// segment is tested against every target box it could touch (cube half size 0.5 plus
+// bullet radius 0.1), so fast bullets cannot tunnel through a cube between updates.
+// Broadphase: targets never move, so they are binned once into a uniform grid over the
+// XZ plane and a bullet only tests the targets in the cells under its segment's bounds.
+const float HIT_HALF_EXTENT = 0.6f;
+const float TARGET_CELL = 2.0f;
+UniformGrid targetGrid; // XZ, shifted by WORLD_HALF_EXTENT so the world starts at 0
+bool bruteForceCollisions = false;
+float bulletSpeed = 30.0f; // units per second
+
+// Entry parameter t in [0, 1] of the segment p + t*d into the box [lo, hi], or -1 on a miss
+float segmentBoxEntry(const float p[3], const float d[3], const float lo[3], const float hi[3]) {
+    float tMin = 0.0f, tMax = 1.0f;
+    for (int a = 0; a < 3; a++) {
+        if (fabs(d[a]) < 1e-12f) {
+            if (p[a] < lo[a] || p[a] > hi[a]) return -1.0f;
+            continue;
+        }
+        float inv = 1.0f / d[a];
+        float t0 = (lo[a] - p[a]) * inv;
+        float t1 = (hi[a] - p[a]) * inv;
+        if (t0 > t1) { float tmp = t0; t0 = t1; t1 = tmp; }
+        if (t0 > tMin) tMin = t0;
+        if (t1 < tMax) tMax = t1;
+        if (tMin > tMax) return -1.0f;
+    }
+    return tMin;
+}
+
+float sweepTarget(const Target& t, const float p[3], const float d[3]) {
+    const float e = HIT_HALF_EXTENT;
+    const float lo[3] = { t.x - e, t.y - e, t.z - e };
+    const float hi[3] = { t.x + e, t.y + e, t.z + e };
+    return segmentBoxEntry(p, d, lo, hi);
+}
+
+void buildTargetGrid() {
+    const float w = WORLD_HALF_EXTENT, e = HIT_HALF_EXTENT;
+    targetGrid.reset(2 * w, 2 * w, TARGET_CELL);
+    for (int i = 0; i < (int)targets.size(); i++) {
+        const Target& t = targets[i];
+        targetGrid.insert(i, t.x - e + w, t.z - e + w, t.x + e + w, t.z + e + w);
+    }
+}
+
+// First alive target along the segment p -> p + d (smallest entry t, ties to the lower
+// index), or -1
+int firstTargetHit(const float p[3], const float d[3]) {
+    int best = -1;
+    float bestT = 2.0f;
+    auto test = [&](int i) {
+        const Target& t = targets[i];
+        if (!t.alive) return;
+        float th = sweepTarget(t, p, d);
+        if (th < 0.0f) return;
+        if (th < bestT || (th == bestT && i < best)) { bestT = th; best = i; }
+    };
+    if (bruteForceCollisions) {
+        for (int i = 0; i < (int)targets.size(); i++) test(i);
+    }
+    else {
+        const float w = WORLD_HALF_EXTENT;
+        float x0 = fmin(p[0], p[0] + d[0]), x1 = fmax(p[0], p[0] + d[0]);
+        float z0 = fmin(p[2], p[2] + d[2]), z1 = fmax(p[2], p[2] + d[2]);
+        targetGrid.query(x0 + w, z0 + w, x1 + w, z1 + w, test);
+    }
+    return best;
+}
+
 // ================== SHOOT BULLET ==================
 void shootBullet() {
     Bullet b;
@@ -35,13 +185,15 @@ void shootBullet() {
     b.y = 1.5f;
     b.z = camZ;
 
-    float speed = 0.5f;
+    float speed = bulletSpeed;
     b.dx = sinf(camYaw) * cosf(camPitch) * speed;
     b.dy = sinf(camPitch) * speed;
     b.dz = -cosf(camYaw) * cosf(camPitch) * speed;
+    b.px = b.x; b.py = b.y; b.pz = b.z;
     b.active = true;
+    b.life = BULLET_LIFE;
 
-    bullets.push_back(b);
+    bullets.spawn(b);
 }
 
 // ================== DRAW GROUND ==================
@@ -69,11 +221,180 @@ void drawSky() {
     glEnable(GL_LIGHTING);
 }
 
+// ================== TIMING ==================
+// The simulation advances in fixed steps of 1/simHz seconds, fed by an accumulator of real
+// time, so game speed no longer depends on how often GLUT calls idle(). Rendering runs at
+// most renderHz times per second (0 = every idle call) and draws bullets and targets
+// interpolated between the last two simulation states by renderAlpha.
+int simHz = 60;
+int renderHz = 0;
+const int MAX_STEPS_PER_IDLE = 8; // when far behind, drop time instead of spiralling
+const float SPIN_DEG_PER_SEC = 30.0f;
+double simAccumulator = 0.0;
+double lastIdleTime = -1.0;
+double lastRenderTime = -1.0;
+float renderAlpha = 1.0f;
+long long simSteps = 0;
+
+double nowSeconds() {
+    using namespace std::chrono;
+    return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+float lerpf(float a, float b, float t) { return a + (b - a) * t; }
+
+// ================== PROFILING ==================
+// Stage timers (profiler.h), off unless --profile or --trace is given. Everything runs on
+// the GLUT thread, so all stages are closed together at the end of each displayed frame;
+// input and simulation steps between two frames count toward the second one.
+enum Stage {
+    STAGE_INPUT, STAGE_UPDATE, STAGE_COLLISION,
+    STAGE_SETUP, STAGE_SKY, STAGE_TARGETS, STAGE_BULLETS, STAGE_GUN, STAGE_HUD, STAGE_SWAP,
+    STAGE_COUNT
+};
+const char* const STAGE_NAMES[STAGE_COUNT] = {
+    "input", "sim.update", "sim.collision",
+    "render.setup", "render.sky", "render.targets", "render.bullets", "render.gun", "render.hud", "render.swap",
+};
+FrameProfiler profiler;
+const char* tracePath = nullptr;
+
+void reportProfile() {
+    printf("\nFrame profile:\n");
+    profiler.printReport(stdout);
+    if (tracePath) {
+        if (profiler.writeTrace(tracePath)) printf("Trace written to %s\n", tracePath);
+        else fprintf(stderr, "Failed to write trace %s\n", tracePath);
+    }
+}
+
+// ================== CULLING & LOD ==================
+// Each frame the view frustum is rebuilt from the camera (camX/Y/Z, camYaw, camPitch and the
+// projection set up in reshape), and targets and bullets whose bounding sphere lies wholly
+// outside it are not submitted. Bullets that remain are drawn at a tessellation level picked
+// by their distance to the camera; targets are always the plain cube (one quad per face, as
+// glutSolidCube draws it), which no level could make cheaper. renderStats counts what was
+// submitted and culled each frame.
+const float FOV_Y_DEG = 60.0f;
+const float Z_NEAR = 0.1f;
+const float Z_FAR = 100.0f;
+const float TARGET_BOUND_RADIUS = 0.87f; // half diagonal of the unit cube, covers any spin
+const float BULLET_BOUND_RADIUS = 0.1f;
+
+const int LOD_LEVELS = 3;
+const float LOD_DISTANCE[LOD_LEVELS - 1] = { 8.0f, 25.0f }; // level 0 closer than 8, 1 closer than 25
+const int BULLET_LOD_SLICES[LOD_LEVELS] = { 12, 8, 5 };
+const int BULLET_LOD_STACKS[LOD_LEVELS] = { 12, 6, 4 };
+
+bool frustumCulling = true;
+bool distanceLod = true;
+float viewAspect = 800.0f / 600.0f;
+
+struct RenderStats {
+    int targetsSubmitted, targetsCulled;
+    int bulletsSubmitted, bulletsCulled;
+    int bulletLod[LOD_LEVELS];
+};
+RenderStats renderStats;
+
+// Six planes with inward normals (a, b, c, d): a point p is inside when a*px + b*py + c*pz + d >= 0
+struct Frustum {
+    float planes[6][4];
+};
+Frustum viewFrustum;
+
+void setPlane(float* plane, float nx, float ny, float nz, float px, float py, float pz) {
+    float len = sqrtf(nx * nx + ny * ny + nz * nz);
+    nx /= len; ny /= len; nz /= len;
+    plane[0] = nx; plane[1] = ny; plane[2] = nz;
+    plane[3] = -(nx * px + ny * py + nz * pz);
+}
+
+// f is the unit view direction passed to gluLookAt
+void buildViewFrustum(float fx, float fy, float fz) {
+    // right = f x worldUp, up = right x f (the basis gluLookAt builds)
+    float rx = -fz, ry = 0.0f, rz = fx;
+    float rl = sqrtf(rx * rx + rz * rz);
+    if (rl < 1e-6f) { rx = 1.0f; rz = 0.0f; rl = 1.0f; }
+    rx /= rl; rz /= rl;
+    float ux = ry * fz - rz * fy, uy = rz * fx - rx * fz, uz = rx * fy - ry * fx;
+
+    float ty = tanf(FOV_Y_DEG * 0.5f * 3.14159265f / 180.0f);
+    float tx = ty * viewAspect;
+    float (*pl)[4] = viewFrustum.planes;
+    setPlane(pl[0], fx * tx - rx, fy * tx - ry, fz * tx - rz, camX, camY, camZ); // right
+    setPlane(pl[1], fx * tx + rx, fy * tx + ry, fz * tx + rz, camX, camY, camZ); // left
+    setPlane(pl[2], fx * ty - ux, fy * ty - uy, fz * ty - uz, camX, camY, camZ); // top
+    setPlane(pl[3], fx * ty + ux, fy * ty + uy, fz * ty + uz, camX, camY, camZ); // bottom
+    setPlane(pl[4], fx, fy, fz, camX + fx * Z_NEAR, camY + fy * Z_NEAR, camZ + fz * Z_NEAR); // near
+    setPlane(pl[5], -fx, -fy, -fz, camX + fx * Z_FAR, camY + fy * Z_FAR, camZ + fz * Z_FAR); // far
+}
+
+bool sphereVisible(float x, float y, float z, float radius) {
+    if (!frustumCulling) return true;
+    for (const auto& p : viewFrustum.planes)
+        if (p[0] * x + p[1] * y + p[2] * z + p[3] < -radius) return false;
+    return true;
+}
+
+int lodLevel(float x, float y, float z) {
+    if (!distanceLod) return 0;
+    float dx = x - camX, dy = y - camY, dz = z - camZ;
+    float d2 = dx * dx + dy * dy + dz * dz;
+    int level = 0;
+    while (level < LOD_LEVELS - 1 && d2 >= LOD_DISTANCE[level] * LOD_DISTANCE[level]) level++;
+    return level;
+}
+
+// ================== MESHES ==================
+// Retained path (default): meshes are tessellated once, and each frame all targets, all
+// bullets and the gun are drawn from client-side vertex arrays with one glDrawElements per
+// mesh type (and LOD level, for bullets; mesh_batch.h). Immediate path (--immediate): the original
+// per-object glutSolidCube / glutSolidSphere / gluCylinder calls.
+bool immediateMode = false;
+Mesh targetMesh, bulletMeshes[LOD_LEVELS];
+DrawList gunMesh; // body, barrel and handle baked in gun space
+InstanceBatch targetBatch, bulletBatches[LOD_LEVELS];
+
+void buildMeshes() {
+    targetMesh = makeCubeMesh(1.0f);
+    for (int l = 0; l < LOD_LEVELS; l++) bulletMeshes[l] = makeSphereMesh(0.1f, BULLET_LOD_SLICES[l], BULLET_LOD_STACKS[l]);
+
+    // same placement as the immediate-mode drawGun
+    const Mesh gunCube = makeCubeMesh(0.5f);
+    gunMesh.clear();
+    gunMesh.append(gunCube, Affine::scale(0.3f, 0.2f, 0.6f), 0.1f, 0.1f, 0.1f); // body
+    gunMesh.append(makeCylinderMesh(0.05f, 0.4f, 16), Affine::translate(0.0f, 0.0f, -0.5f), 0.6f, 0.6f, 0.6f); // barrel
+    gunMesh.append(gunCube, Affine::translate(0.0f, -0.25f, 0.1f) * Affine::rotateX(70.0f) * Affine::scale(0.15f, 0.5f, 0.2f),
+        0.4f, 0.2f, 0.05f); // handle
+}
+
+// Submit an indexed vertex stream through the GL 1.1 client arrays; the per-vertex colors
+// drive GL_COLOR_MATERIAL just like glColor3f does in immediate mode
+void drawVertexArrays(const std::vector<BatchVertex>& v, const uint32_t* indices, size_t count) {
+    if (count == 0) return;
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_NORMAL_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    glVertexPointer(3, GL_FLOAT, sizeof(BatchVertex), &v[0].px);
+    glNormalPointer(GL_FLOAT, sizeof(BatchVertex), &v[0].nx);
+    glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(BatchVertex), &v[0].r);
+    glDrawElements(GL_TRIANGLES, (GLsizei)count, GL_UNSIGNED_INT, indices);
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_NORMAL_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+}
+
+void drawBatch(InstanceBatch& batch) {
+    batch.finish();
+    drawVertexArrays(batch.vertices, batch.indices.data(), batch.indexCount());
+}
+
 // ================== DRAW TARGET ==================
 void drawTarget(Target& t) {
     glPushMatrix();
     glTranslatef(t.x, t.y, t.z);
-    glRotatef(t.spinAngle, 0, 1, 0);
+    glRotatef(lerpf(t.prevSpin, t.spinAngle, renderAlpha), 0, 1, 0);
 
     glColor3f(t.r, t.g, t.b); // fixed color
     glutSolidCube(1.0f);
@@ -81,55 +402,81 @@ void drawTarget(Target& t) {
     glPopMatrix();
 }
 
+void drawTargets() {
+    if (!immediateMode) targetBatch.begin(targetMesh);
+    for (auto& t : targets) {
+        if (!t.alive) continue;
+        if (!sphereVisible(t.x, t.y, t.z, TARGET_BOUND_RADIUS)) { renderStats.targetsCulled++; continue; }
+        renderStats.targetsSubmitted++;
+        if (immediateMode) drawTarget(t);
+        else targetBatch.addYaw(t.x, t.y, t.z, lerpf(t.prevSpin, t.spinAngle, renderAlpha), t.r, t.g, t.b);
+    }
+    if (!immediateMode) drawBatch(targetBatch);
+}
+
 // ================== DRAW BULLETS ==================
 void drawBullets() {
-    for (auto& b : bullets) {
-        if (b.active) {
-            glPushMatrix();
-            glTranslatef(b.x, b.y, b.z);
-            glColor3f(1.0f, 0.8f, 0.0f); // glowing yellow
-            glutSolidSphere(0.1, 12, 12);
-            glPopMatrix();
+    if (!immediateMode)
+        for (int l = 0; l < LOD_LEVELS; l++) bulletBatches[l].begin(bulletMeshes[l]);
+    for (int i = 0; i < bullets.live; i++) {
+        const Bullet& b = bullets.slots[i];
+        float x = lerpf(b.px, b.x, renderAlpha), y = lerpf(b.py, b.y, renderAlpha), z = lerpf(b.pz, b.z, renderAlpha);
+        if (!sphereVisible(x, y, z, BULLET_BOUND_RADIUS)) { renderStats.bulletsCulled++; continue; }
+        renderStats.bulletsSubmitted++;
+        int level = lodLevel(x, y, z);
+        renderStats.bulletLod[level]++;
+        if (!immediateMode) {
+            bulletBatches[level].add(x, y, z, 1.0f, 0.8f, 0.0f);
+            continue;
         }
+        glPushMatrix();
+        glTranslatef(x, y, z);
+        glColor3f(1.0f, 0.8f, 0.0f); // glowing yellow
+        glutSolidSphere(0.1, BULLET_LOD_SLICES[level], BULLET_LOD_STACKS[level]);
+        glPopMatrix();
     }
+    if (!immediateMode)
+        for (auto& batch : bulletBatches) drawBatch(batch);
 }
 
 // ================== UPDATE BULLETS ==================
-void updateBullets() {
-    for (auto& b : bullets) {
-        if (b.active) {
-            b.x += b.dx;
-            b.y += b.dy;
-            b.z += b.dz;
-
-            // Check collision with targets
-            for (auto& t : targets) {
-                if (t.alive &&
-                    fabs(b.x - t.x) < 0.6 &&
-                    fabs(b.y - t.y) < 0.6 &&
-                    fabs(b.z - t.z) < 0.6) {
-                    t.alive = false;
-                    b.active = false;
-                    score += 10;
-                }
-            }
+bool outOfWorld(const Bullet& b) {
+    return b.y < 0.0f || b.y > WORLD_HALF_EXTENT ||
+        fabs(b.x) > WORLD_HALF_EXTENT || fabs(b.z) > WORLD_HALF_EXTENT;
+}
+
+void updateBullets(float dt) {
+    int i = 0;
+    while (i < bullets.live) {
+        Bullet& b = bullets.slots[i];
+        const float p[3] = { b.x, b.y, b.z };
+        const float d[3] = { b.dx * dt, b.dy * dt, b.dz * dt };
+        b.px = b.x; b.py = b.y; b.pz = b.z;
+        b.x += d[0];
+        b.y += d[1];
+        b.z += d[2];
+        b.life -= dt;
+
+        // Swept collision with targets: the bullet stops at the first box it enters
+        int hit;
+        {
+            ProfileScope scope(profiler, STAGE_COLLISION);
+            hit = firstTargetHit(p, d);
+        }
+        if (hit >= 0) {
+            targets[hit].alive = false;
+            b.active = false;
+            score += 10;
         }
+
+        if (!b.active || b.life <= 0.0f || outOfWorld(b)) bullets.recycle(i);
+        else i++;
     }
 }
 
 // ================== DRAW GUN ==================
-void drawGun() {
-    glMatrixMode(GL_PROJECTION);
-    glPushMatrix();
-    glLoadIdentity();
-    gluPerspective(60, 800.0 / 600.0, 0.1, 100);
-
-    glMatrixMode(GL_MODELVIEW);
-    glPushMatrix();
-    glLoadIdentity();
-
-    glTranslatef(0.5f, -0.5f, -1.2f);
-
+// Immediate-mode gun parts, in gun space
+void drawGunParts() {
     // Body
     glColor3f(0.1f, 0.1f, 0.1f);
     glPushMatrix();
@@ -154,6 +501,22 @@ void drawGun() {
     glScalef(0.15f, 0.5f, 0.2f);
     glutSolidCube(0.5f);
     glPopMatrix();
+}
+
+void drawGun() {
+    glMatrixMode(GL_PROJECTION);
+    glPushMatrix();
+    glLoadIdentity();
+    gluPerspective(60, 800.0 / 600.0, 0.1, 100);
+
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    glLoadIdentity();
+
+    glTranslatef(0.5f, -0.5f, -1.2f);
+
+    if (immediateMode) drawGunParts();
+    else drawVertexArrays(gunMesh.vertices, gunMesh.indices.data(), gunMesh.indices.size());
 
     glPopMatrix();
     glMatrixMode(GL_PROJECTION);
@@ -163,51 +526,203 @@ void drawGun() {
 
 // ================== DISPLAY FUNCTION ==================
 void display() {
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    glLoadIdentity();
+    {
+        ProfileScope scope(profiler, STAGE_SETUP);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        glLoadIdentity();
+
+        float lx = cosf(camPitch) * sinf(camYaw);
+        float ly = sinf(camPitch);
+        float lz = -cosf(camYaw) * cosf(camPitch);
+
+        gluLookAt(camX, camY, camZ,
+            camX + lx, camY + ly, camZ + lz,
+            0, 1, 0);
+        buildViewFrustum(lx, ly, lz);
+        renderStats = RenderStats{};
+    }
+
+    {
+        ProfileScope scope(profiler, STAGE_SKY);
+        drawSky();
+        drawGround();
+    }
 
-    float lx = cosf(camPitch) * sinf(camYaw);
-    float ly = sinf(camPitch);
-    float lz = -cosf(camYaw) * cosf(camPitch);
+    {
+        ProfileScope scope(profiler, STAGE_TARGETS);
+        drawTargets();
+    }
+    {
+        ProfileScope scope(profiler, STAGE_BULLETS);
+        drawBullets();
+    }
+    {
+        ProfileScope scope(profiler, STAGE_GUN);
+        drawGun();
+    }
 
-    gluLookAt(camX, camY, camZ,
-        camX + lx, camY + ly, camZ + lz,
-        0, 1, 0);
+    // Score display
+    {
+        ProfileScope scope(profiler, STAGE_HUD);
+        glDisable(GL_LIGHTING);
+        glColor3f(1.0f, 1.0f, 0.0f);
+        std::string scoreText = "Score: " + std::to_string(score);
+        glRasterPos2f(-3.5f, 2.0f);
+        for (char c : scoreText) glutBitmapCharacter(GLUT_BITMAP_HELVETICA_18, c);
+        std::string bulletText = "Bullets: " + std::to_string(bullets.live) + " live / " + std::to_string(bullets.peak) + " peak";
+        glRasterPos2f(-3.5f, 1.8f);
+        for (char c : bulletText) glutBitmapCharacter(GLUT_BITMAP_HELVETICA_12, c);
+        const RenderStats& rs = renderStats;
+        std::string drawnText = "Drawn: " + std::to_string(rs.targetsSubmitted) + " targets (" + std::to_string(rs.targetsCulled) +
+            " culled), " + std::to_string(rs.bulletsSubmitted) + " bullets (" + std::to_string(rs.bulletsCulled) + " culled)";
+        glRasterPos2f(-3.5f, 1.65f);
+        for (char c : drawnText) glutBitmapCharacter(GLUT_BITMAP_HELVETICA_12, c);
+        glEnable(GL_LIGHTING);
+    }
 
-    drawSky();
-    drawGround();
+    {
+        ProfileScope scope(profiler, STAGE_SWAP);
+        glutSwapBuffers();
+    }
+    profiler.endFrame(0, STAGE_COUNT - 1);
+}
 
-    for (auto& t : targets)
-        if (t.alive) drawTarget(t);
+// ================== SIMULATION STEP ==================
+void stepSimulation(float dt) {
+    ProfileScope scope(profiler, STAGE_UPDATE);
+    updateBullets(dt);
 
-    drawBullets();
-    drawGun();
+    // Spin targets
+    for (auto& t : targets) {
+        t.prevSpin = t.spinAngle;
+        if (t.alive) t.spinAngle += SPIN_DEG_PER_SEC * dt;
+    }
+    simSteps++;
+}
 
-    // Score display
-    glDisable(GL_LIGHTING);
-    glColor3f(1.0f, 1.0f, 0.0f);
-    std::string scoreText = "Score: " + std::to_string(score);
-    glRasterPos2f(-3.5f, 2.0f);
-    for (char c : scoreText) glutBitmapCharacter(GLUT_BITMAP_HELVETICA_18, c);
-    glEnable(GL_LIGHTING);
+// ================== RESHAPE ==================
+void reshape(int w, int h) {
+    if (h == 0) h = 1;
+    float ratio = 1.0f * w / h;
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+    gluPerspective(FOV_Y_DEG, ratio, Z_NEAR, Z_FAR);
+    viewAspect = ratio;
+    glViewport(0, 0, w, h);
+    glMatrixMode(GL_MODELVIEW);
+}
+
+// ================== RENDER BENCHMARK ==================
+// --bench N: N targets and N bullets frozen in flight in front of the camera are drawn
+// BENCH_FRAMES times with each path; the mean frame time (glFinish included) is printed
+// as JSON and the program exits.
+int benchCount = 0;
+const int BENCH_WARMUP_FRAMES = 5;
+const int BENCH_FRAMES = 60;
+
+void fillBenchBullets() {
+    for (int i = 0; i < benchCount; i++) {
+        Bullet b = {};
+        b.x = (float)(benchRng.below(40) - 20);
+        b.y = 0.5f + benchRng.below(40) / 10.0f;
+        b.z = -1.0f - (float)benchRng.below(40);
+        b.px = b.x; b.py = b.y; b.pz = b.z;
+        b.active = true;
+        b.life = BULLET_LIFE;
+        bullets.spawn(b);
+    }
+}
 
-    glutSwapBuffers();
+void runRenderBench() {
+    reshape(glutGet(GLUT_WINDOW_WIDTH), glutGet(GLUT_WINDOW_HEIGHT));
+    renderAlpha = 1.0f;
+    double msPerFrame[2];
+    for (int pass = 0; pass < 2; pass++) {
+        immediateMode = pass == 0;
+        for (int f = 0; f < BENCH_WARMUP_FRAMES; f++) { display(); glFinish(); }
+        double t0 = nowSeconds();
+        for (int f = 0; f < BENCH_FRAMES; f++) { display(); glFinish(); }
+        msPerFrame[pass] = (nowSeconds() - t0) * 1000.0 / BENCH_FRAMES;
+    }
+    const RenderStats& rs = renderStats; // last retained frame
+    printf("{\"benchmark\": \"3Dshooter_render\", \"renderer\": \"%s\", \"targets\": %d, \"bullets\": %d, "
+        "\"frames\": %d, \"immediate_ms_per_frame\": %.3f, \"retained_ms_per_frame\": %.3f, \"speedup\": %.2f, "
+        "\"frustum_culling\": %s, \"lod\": %s, \"targets_submitted\": %d, \"targets_culled\": %d, "
+        "\"bullets_submitted\": %d, \"bullets_culled\": %d, \"bullet_lod\": [%d, %d, %d]}\n",
+        (const char*)glGetString(GL_RENDERER), (int)targets.size(), bullets.live, BENCH_FRAMES,
+        msPerFrame[0], msPerFrame[1], msPerFrame[0] / msPerFrame[1],
+        frustumCulling ? "true" : "false", distanceLod ? "true" : "false",
+        rs.targetsSubmitted, rs.targetsCulled, rs.bulletsSubmitted, rs.bulletsCulled,
+        rs.bulletLod[0], rs.bulletLod[1], rs.bulletLod[2]);
+    exit(0);
 }
 
 // ================== IDLE FUNCTION ==================
 void idle() {
-    updateBullets();
+    if (benchCount > 0) runRenderBench();
+
+    const double step = 1.0 / simHz;
+    double now = nowSeconds();
+    if (lastIdleTime < 0.0) lastIdleTime = now;
+    simAccumulator += now - lastIdleTime;
+    lastIdleTime = now;
+
+    int steps = 0;
+    while (simAccumulator >= step && steps < MAX_STEPS_PER_IDLE) {
+        stepSimulation((float)step);
+        simAccumulator -= step;
+        steps++;
+    }
+    if (simAccumulator >= step) simAccumulator = fmod(simAccumulator, step);
+    renderAlpha = (float)(simAccumulator / step);
+
+    // render only when the render interval has elapsed; otherwise yield until the next
+    // simulation step or frame is due instead of spinning
+    double renderInterval = renderHz > 0 ? 1.0 / renderHz : 0.0;
+    if (lastRenderTime < 0.0 || now - lastRenderTime >= renderInterval) {
+        lastRenderTime = now;
+        glutPostRedisplay();
+    }
+    else {
+        double untilStep = step - simAccumulator;
+        double untilRender = lastRenderTime + renderInterval - now;
+        double wait = untilStep < untilRender ? untilStep : untilRender;
+        if (wait > 0.001) std::this_thread::sleep_for(std::chrono::duration<double>(wait * 0.5));
+    }
+}
 
-    // Spin targets
-    for (auto& t : targets) {
-        if (t.alive) t.spinAngle += 0.5f;
+// ================== RECORD / REPLAY ==================
+// With --record every input event is written with the simulation step it preceded
+// (replay.h); --replay runs those steps again headless (see runReplay). Events are logged
+// after GLUT's window-specific handling, as the camera moves and shots they cause, so a
+// replay needs no window.
+InputRecorder recorder;
+double recordStart = 0.0;
+const char* replayPath = nullptr;
+
+void recordInput(char type, double a = 0.0, double b = 0.0) {
+    if (recorder.active()) recorder.event((uint64_t)simSteps, nowSeconds() - recordStart, type, a, b);
+}
+
+uint64_t simulationChecksum() {
+    StateHash h;
+    h.add((uint64_t)score);
+    h.add(camX); h.add(camZ); h.add(camYaw); h.add(camPitch);
+    for (const Target& t : targets) h.add((uint64_t)t.alive);
+    for (int i = 0; i < bullets.live; i++) {
+        const Bullet& b = bullets.slots[i];
+        h.add(b.x); h.add(b.y); h.add(b.z);
     }
+    return h.h;
+}
 
-    glutPostRedisplay();
+void finishRecording() {
+    recorder.finish((uint64_t)simSteps, score, simulationChecksum());
 }
 
 // ================== KEYBOARD ==================
-void keyboard(unsigned char key, int, int) {
+// WASD movement relative to the view direction
+void applyMoveKey(unsigned char key) {
     float speed = 0.3f;
     float lx = sinf(camYaw);
     float lz = -cosf(camYaw);
@@ -216,11 +731,27 @@ void keyboard(unsigned char key, int, int) {
     if (key == 's') { camX -= lx * speed; camZ -= lz * speed; }
     if (key == 'a') { camX += lz * speed; camZ -= lx * speed; }
     if (key == 'd') { camX -= lz * speed; camZ += lx * speed; }
+}
+
+void keyboard(unsigned char key, int, int) {
+    ProfileScope scope(profiler, STAGE_INPUT);
     if (key == 27) exit(0);
+    recordInput('k', key);
+    applyMoveKey(key);
 }
 
 // ================== MOUSE LOOK ==================
+// turn by dx (yaw) and dy (pitch, clamped) radians
+void applyLook(float dx, float dy) {
+    camYaw += dx;
+    camPitch -= dy;
+
+    if (camPitch > 1.5f) camPitch = 1.5f;
+    if (camPitch < -1.5f) camPitch = -1.5f;
+}
+
 void mouseMotion(int x, int y) {
+    ProfileScope scope(profiler, STAGE_INPUT);
     static bool warp = false;
     if (warp) { warp = false; return; }
 
@@ -229,12 +760,8 @@ void mouseMotion(int x, int y) {
 
     float dx = (x - cx) * 0.002f;
     float dy = (y - cy) * 0.002f;
-
-    camYaw += dx;
-    camPitch -= dy;
-
-    if (camPitch > 1.5f) camPitch = 1.5f;
-    if (camPitch < -1.5f) camPitch = -1.5f;
+    recordInput('l', dx, dy);
+    applyLook(dx, dy);
 
     glutWarpPointer(cx, cy);
     warp = true;
@@ -242,23 +769,139 @@ void mouseMotion(int x, int y) {
 
 // ================== MOUSE CLICK ==================
 void mouseClick(int button, int state, int, int) {
-    if (button == GLUT_LEFT_BUTTON && state == GLUT_DOWN) shootBullet();
+    ProfileScope scope(profiler, STAGE_INPUT);
+    if (button == GLUT_LEFT_BUTTON && state == GLUT_DOWN) {
+        recordInput('c');
+        shootBullet();
+    }
 }
 
-// ================== RESHAPE ==================
-void reshape(int w, int h) {
-    if (h == 0) h = 1;
-    float ratio = 1.0f * w / h;
-    glMatrixMode(GL_PROJECTION);
-    glLoadIdentity();
-    gluPerspective(60, ratio, 0.1, 100);
-    glViewport(0, 0, w, h);
-    glMatrixMode(GL_MODELVIEW);
+// ================== TARGET SETUP ==================
+// Create targets with fixed random colors (large counts are spread over the whole field)
+void createTargets(int targetCount) {
+    int spread = targetCount > 10 ? 90 : 20;
+    for (int i = 0; i < targetCount; i++) {
+        float tx = (float)(targetRng.below(spread) - spread / 2);
+        float tz = targetCount > 10 ? (float)(targetRng.below(spread) - spread / 2) : (float)(-targetRng.below(20));
+        targets.push_back({
+            tx,
+            0.5f,
+            tz,
+            true,
+            0.0f,
+            targetRng.below(100) / 100.0f,   // R
+            targetRng.below(100) / 100.0f,   // G
+            targetRng.below(100) / 100.0f,   // B
+            0.0f                             // prevSpin, same as spinAngle
+            });
+    }
+    buildTargetGrid();
+}
+
+// ================== HEADLESS REPLAY ==================
+// --replay FILE: rebuild the recorded game from its seed and options, then run every
+// recorded step with its input events as fast as possible, without GLUT or GL. Prints the
+// simulated steps per second and whether the final state matches the recording.
+int runReplay() {
+    ReplayLog log;
+    std::string error;
+    if (!log.load(replayPath, "3Dshooter", error)) {
+        fprintf(stderr, "Cannot replay %s: %s\n", replayPath, error.c_str());
+        return 1;
+    }
+    seedRandomStreams(log.seed);
+    bulletSpeed = (float)log.option("bullet-speed", bulletSpeed);
+    simHz = (int)log.option("sim-hz", simHz);
+    bullets.reset(MAX_BULLETS);
+    createTargets((int)log.option("targets", 10));
+
+    const float step = 1.0f / simHz;
+    const uint64_t steps = log.hasFinal ? log.finalSteps : (log.events.empty() ? 0 : log.events.back().step);
+    size_t next = 0;
+    double t0 = nowSeconds();
+    for (uint64_t s = 0; s <= steps; s++) {
+        {
+            ProfileScope scope(profiler, STAGE_INPUT);
+            for (; next < log.events.size() && log.events[next].step == s; next++) {
+                const InputEvent& e = log.events[next];
+                if (e.type == 'k') applyMoveKey((unsigned char)e.a);
+                else if (e.type == 'l') applyLook((float)e.a, (float)e.b);
+                else if (e.type == 'c') shootBullet();
+            }
+        }
+        if (s == steps) break; // events after the last step
+        stepSimulation(step);
+        profiler.endFrame(0, STAGE_COUNT - 1);
+    }
+    double seconds = nowSeconds() - t0;
+
+    uint64_t checksum = simulationChecksum();
+    printf("Replayed %lld steps (%.1f s of game time) in %.3f s: %.0f simulated FPS\n",
+        simSteps, simSteps * (double)step, seconds, simSteps / (seconds > 1e-9 ? seconds : 1e-9));
+    printf("Final score %d, state %016llx\n", score, (unsigned long long)checksum);
+    bool match = true;
+    if (log.hasFinal) {
+        match = log.finalSteps == (uint64_t)simSteps && log.finalScore == score && log.finalChecksum == checksum;
+        printf(match ? "Matches the recording\n" : "DIFFERS from the recording\n");
+    }
+    return match ? 0 : 1;
 }
 
 // ================== MAIN ==================
 int main(int argc, char** argv) {
-    glutInit(&argc, argv);
+    // a headless replay needs no display, so GLUT is only initialized otherwise
+    bool headless = false;
+    for (int i = 1; i < argc; i++)
+        if (strcmp(argv[i], "--replay") == 0) headless = true;
+    if (!headless) glutInit(&argc, argv);
+    int targetCount = 10;
+    const char* recordPath = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--targets") == 0 && i + 1 < argc) targetCount = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--bullet-speed") == 0 && i + 1 < argc) bulletSpeed = (float)atof(argv[++i]);
+        else if (strcmp(argv[i], "--brute-force") == 0) bruteForceCollisions = true;
+        else if (strcmp(argv[i], "--sim-hz") == 0 && i + 1 < argc) simHz = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--render-hz") == 0 && i + 1 < argc) renderHz = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--immediate") == 0) immediateMode = true;
+        else if (strcmp(argv[i], "--no-cull") == 0) frustumCulling = false;
+        else if (strcmp(argv[i], "--no-lod") == 0) distanceLod = false;
+        else if (strcmp(argv[i], "--bench") == 0 && i + 1 < argc) targetCount = benchCount = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--profile") == 0) profiler.enable(false);
+        else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            tracePath = argv[++i];
+            profiler.enable(true);
+        }
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) runSeed = strtoull(argv[++i], nullptr, 10);
+        else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) recordPath = argv[++i];
+        else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) replayPath = argv[++i];
+        else {
+            fprintf(stderr, "Usage: %s [--targets N] [--bullet-speed S] [--brute-force] [--sim-hz H] [--render-hz R]"
+                " [--immediate] [--no-cull] [--no-lod] [--bench N] [--profile] [--trace FILE]"
+                " [--seed N] [--record FILE] [--replay FILE]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (simHz < 1) simHz = 1;
+    if (renderHz < 0) renderHz = 0;
+    // GLUT leaves its main loop only through exit()
+    profiler.setStages(STAGE_NAMES, STAGE_COUNT);
+    if (profiler.enabled) atexit(reportProfile);
+    if (replayPath) return runReplay();
+
+    seedRandomStreams(runSeed);
+    if (recordPath) {
+        if (!recorder.open(recordPath, "3Dshooter", runSeed)) {
+            fprintf(stderr, "Cannot write %s\n", recordPath);
+            return 1;
+        }
+        recorder.option("targets", targetCount);
+        recorder.option("bullet-speed", bulletSpeed);
+        recorder.option("sim-hz", simHz);
+        recorder.beginEvents();
+        recordStart = nowSeconds();
+        atexit(finishRecording);
+    }
+
     glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGB | GLUT_DEPTH);
     glutInitWindowSize(800, 600);
     glutCreateWindow("FPS Shooting Game");
@@ -271,19 +914,11 @@ int main(int argc, char** argv) {
     GLfloat lightPos[] = { 0.0f, 10.0f, 5.0f, 1.0f };
     glLightfv(GL_LIGHT0, GL_POSITION, lightPos);
 
-    // Create targets with fixed random colors
-    for (int i = 0; i < 10; i++) {
-        targets.push_back({
-            (float)(rand() % 20 - 10),
-            0.5f,
-            (float)(-(rand() % 20)),
-            true,
-            0.0f,
-            (rand() % 100) / 100.0f,   // R
-            (rand() % 100) / 100.0f,   // G
-            (rand() % 100) / 100.0f    // B
-            });
-    }
+    bullets.reset(benchCount > MAX_BULLETS ? benchCount : MAX_BULLETS);
+    buildMeshes();
+
+    createTargets(targetCount);
+    fillBenchBullets();
 
     glutDisplayFunc(display);
     glutReshapeFunc(reshape);
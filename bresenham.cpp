@@ -1,59 +1,383 @@
+// bresenham.cpp
+// Bresenham line points, either for one segment typed on stdin or for a whole file of segments.
+// Build: g++ -O2 -std=c++17 -pthread bresenham.cpp -o bresenham
+// Run:   bresenham                                   (interactive, one segment)
+//        bresenham --batch in.txt out.bin [--text] [--threads N]
+//
+// Batch input is text with one segment "x0 y0 x1 y1" per line (blank lines are skipped; any
+// other line stops the run with its line number), each coordinate a 32-bit integer and
+// |x1 - x0|, |y1 - y0| at most 2^30 - 1. The file is memory-mapped, cut into line-aligned
+// chunks and rasterized on all cores; chunks are written back in input order. A chunk buffers
+// at most 16 MB of output; a segment longer than that is streamed to the file on its own.
+// Binary output is, per segment, an int32 point count followed by that many int32 (x, y)
+// pairs (native byte order). --text writes "(x, y)" lines instead, with an empty line after
+// each segment.
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
 #include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "raster.h"
 using namespace std;
 
-void plot(int x, int y) {
-    cout << "(" << x << ", " << y << ")\n";
+// Print every point of the line; the algorithm is raster::lineBresenhamMajorAxis, run as
+// its octant-specialized form (same points, same order)
+void bresenham(int x0, int y0, int x1, int y1) {
+    raster::lineBresenhamMajorAxisOctant(raster::StreamSink{ cout }, x0, y0, x1, y1);
 }
 
-void bresenham(int x0, int y0, int x1, int y1) {
-    int dx = x1 - x0;
-    int dy = y1 - y0;
-
-    int sx, sy;
-    if (dx >= 0) {
-        sx = 1;
-    } else {
-        sx = -1;
+// ----- Batch mode -----
+
+// Read-only memory mapping of a whole file
+struct MappedFile {
+    const char* data = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#endif
+
+    bool open(const char* path) {
+#ifdef _WIN32
+        file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER len;
+        if (!GetFileSizeEx(file, &len)) return false;
+        size = (size_t)len.QuadPart;
+        if (size == 0) return true;
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mapping) return false;
+        data = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        return data != nullptr;
+#else
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0) { ::close(fd); return false; }
+        size = (size_t)st.st_size;
+        if (size == 0) { ::close(fd); return true; }
+        void* p = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) return false;
+        madvise(p, size, MADV_SEQUENTIAL);
+        data = (const char*)p;
+        return true;
+#endif
+    }
+
+    ~MappedFile() {
+#ifdef _WIN32
+        if (data) UnmapViewOfFile(data);
+        if (mapping) CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+#else
+        if (data) munmap((void*)data, size);
+#endif
+    }
+};
+
+// Writes points as packed int32 (x, y) pairs into storage sized by the caller
+struct PackedPointSink {
+    int32_t* out;
+    void plot(int x, int y) { out[0] = x; out[1] = y; out += 2; }
+    void span(int x0, int x1, int y) {
+        for (int x = x0; x <= x1; ++x) plot(x, y);
+    }
+};
+
+// Appends points as "(x, y)\n" text without going through iostream formatting
+struct TextPointSink {
+    vector<char>& out;
+    void plot(int x, int y) {
+        char buf[32]; // "(" + 11 + ", " + 11 + ")\n" fits
+        char* p = buf;
+        *p++ = '(';
+        p = to_chars(p, buf + 12, x).ptr;
+        *p++ = ',';
+        *p++ = ' ';
+        p = to_chars(p, buf + 26, y).ptr;
+        *p++ = ')';
+        *p++ = '\n';
+        out.insert(out.end(), buf, p);
+    }
+    void span(int x0, int x1, int y) {
+        for (int x = x0; x <= x1; ++x) plot(x, y);
     }
+};
 
-    if (dy >= 0) {
-        sy = 1;
-    } else {
-        sy = -1;
+// Largest |x1 - x0| or |y1 - y0| of a batch segment: the Bresenham kernels keep twice the
+// major-axis length in an int error term
+const int64_t MAX_SEGMENT_DELTA = INT32_MAX / 2;
+
+// Output a chunk may buffer before it stops and leaves the rest of its input for a later round,
+// and the size of the buffer a segment too long for any chunk is streamed through
+const size_t CHUNK_OUTPUT_BYTES = 16 << 20;
+const size_t STREAM_BUFFER_BYTES = 1 << 20;
+const size_t MAX_TEXT_POINT_BYTES = 27; // "(" + 11 + ", " + 11 + ")\n"
+
+// One line-aligned slice of the input and its rasterized output
+struct Chunk {
+    const char* begin;
+    const char* end;
+    vector<int32_t> packed;
+    vector<char> text;
+    uint64_t segments = 0;
+    uint64_t points = 0;
+    const char* error = nullptr;     // start of the first bad line, if any
+    const char* errorWhat = nullptr; // what was wrong with it
+    const char* resume = nullptr;    // first line not rasterized because the output budget ran out
+    bool done = false;               // rasterized, waiting to be written
+};
+
+enum class LineParse { Segment, Blank, Malformed, OutOfRange };
+
+// Parse one input line [p, eol): four decimal integers separated by blanks, or nothing but
+// blanks. A line with fewer or more numbers, or anything else on it, is malformed.
+LineParse parseLine(const char* p, const char* eol, int v[4]) {
+    auto blank = [](char ch) { return ch == ' ' || ch == '\t' || ch == '\r'; };
+    while (p < eol && blank(*p)) ++p;
+    if (p == eol) return LineParse::Blank;
+    for (int i = 0; i < 4; ++i) {
+        auto r = from_chars(p, eol, v[i]);
+        if (r.ec == errc::result_out_of_range) return LineParse::OutOfRange;
+        if (r.ec != errc() || (r.ptr < eol && !blank(*r.ptr))) return LineParse::Malformed;
+        p = r.ptr;
+        while (p < eol && blank(*p)) ++p;
+        if (i < 3 && p == eol) return LineParse::Malformed;
     }
+    if (p != eol) return LineParse::Malformed;
+    if (llabs((int64_t)v[2] - v[0]) > MAX_SEGMENT_DELTA || llabs((int64_t)v[3] - v[1]) > MAX_SEGMENT_DELTA) return LineParse::OutOfRange;
+    return LineParse::Segment;
+}
+
+// the major-axis Bresenham emits exactly max(|dx|, |dy|) + 1 points
+int64_t segmentPoints(const int v[4]) {
+    return max(llabs((int64_t)v[2] - v[0]), llabs((int64_t)v[3] - v[1])) + 1;
+}
 
-    if (dx < 0) dx = -dx;
-    if (dy < 0) dy = -dy;
+uint64_t segmentOutputBytes(int64_t n, bool textOutput) {
+    return textOutput ? (uint64_t)n * MAX_TEXT_POINT_BYTES + 1 : (1 + 2 * (uint64_t)n) * sizeof(int32_t);
+}
 
-    int x = x0;
-    int y = y0;
+// End of the line starting at p (its newline, or end)
+const char* lineEnd(const char* p, const char* end) {
+    const char* nl = (const char*)memchr(p, '\n', (size_t)(end - p));
+    return nl ? nl : end;
+}
 
-    if (dx > dy) {
-        int p = 2 * dy - dx;
-        for (int i = 0; i <= dx; i++) {
-            plot(x, y);
-            x = x + sx;
-            if (p >= 0) {
-                y = y + sy;
-                p = p - 2 * dx;
+// Rasterize [c.begin, c.end) line by line until the input ends, a line is bad (c.error), or
+// the next segment would take the buffered output past CHUNK_OUTPUT_BYTES (c.resume)
+void rasterizeChunk(Chunk& c, bool textOutput) {
+    int v[4];
+    uint64_t outputBytes = 0;
+    for (const char* p = c.begin; p < c.end;) {
+        const char* eol = lineEnd(p, c.end);
+        LineParse r = parseLine(p, eol, v);
+        if (r == LineParse::Malformed || r == LineParse::OutOfRange) {
+            c.error = p;
+            c.errorWhat = r == LineParse::Malformed ? "malformed segment" : "segment out of range";
+            return;
+        }
+        if (r == LineParse::Segment) {
+            const int64_t n = segmentPoints(v);
+            const uint64_t bytes = segmentOutputBytes(n, textOutput);
+            if (outputBytes + bytes > CHUNK_OUTPUT_BYTES) {
+                c.resume = p;
+                return;
+            }
+            outputBytes += bytes;
+            if (textOutput) {
+                raster::lineBresenhamMajorAxisOctant(TextPointSink{ c.text }, v[0], v[1], v[2], v[3]);
+                c.text.push_back('\n');
             }
-            p = p + 2 * dy;
+            else {
+                size_t header = c.packed.size();
+                c.packed.resize(header + 1 + 2 * (size_t)n);
+                c.packed[header] = (int32_t)n;
+                raster::lineBresenhamMajorAxisOctant(PackedPointSink{ c.packed.data() + header + 1 }, v[0], v[1], v[2], v[3]);
+            }
+            c.points += (uint64_t)n;
+            ++c.segments;
         }
-    } else {
-        int p = 2 * dx - dy;
-        for (int i = 0; i <= dy; i++) {
-            plot(x, y);
-            y = y + sy;
-            if (p >= 0) {
-                x = x + sx;
-                p = p - 2 * dy;
+        p = eol + 1;
+    }
+}
+
+// Writes one segment's points straight to the output file through a bounded buffer, for
+// segments whose output alone is larger than a chunk may hold
+struct StreamingPointSink {
+    FILE* out;
+    bool textOutput;
+    vector<char> buffer;
+
+    void plot(int x, int y) {
+        if (textOutput) TextPointSink{ buffer }.plot(x, y);
+        else {
+            const int32_t xy[2] = { x, y };
+            buffer.insert(buffer.end(), (const char*)xy, (const char*)(xy + 2));
+        }
+        if (buffer.size() >= STREAM_BUFFER_BYTES) flush();
+    }
+    void span(int x0, int x1, int y) {
+        for (int x = x0; x <= x1; ++x) plot(x, y);
+    }
+    void flush() {
+        fwrite(buffer.data(), 1, buffer.size(), out);
+        buffer.clear();
+    }
+};
+
+int runBatch(const char* inPath, const char* outPath, bool textOutput, unsigned threads) {
+    using clock = chrono::steady_clock;
+    auto t0 = clock::now();
+
+    MappedFile in;
+    if (!in.open(inPath)) {
+        cerr << "cannot map " << inPath << "\n";
+        return 1;
+    }
+    FILE* out = fopen(outPath, "wb");
+    if (!out) {
+        cerr << "cannot write " << outPath << "\n";
+        return 1;
+    }
+
+    // Chunks of ~1 MB of input, cut after a newline, wait in input order in `pending`. Each
+    // round tops it up to `threads` chunks and rasterizes the new ones in parallel; the
+    // writer then takes finished chunks from the front. A chunk that ran out of output budget
+    // is written up to where it stopped and its rest goes back to the front for the next
+    // round, so output memory stays bounded for arbitrarily large inputs and segments.
+    const size_t chunkBytes = 1 << 20;
+    const char* const base = in.data;
+    const char* const end = in.data + in.size;
+    const char* next = base;
+    uint64_t segments = 0, points = 0;
+    deque<Chunk> pending;
+
+    while (next < end || !pending.empty()) {
+        while (next < end && pending.size() < threads) {
+            const char* stop = next + min(chunkBytes, (size_t)(end - next));
+            if (stop < end) {
+                const char* nl = (const char*)memchr(stop, '\n', (size_t)(end - stop));
+                stop = nl ? nl + 1 : end;
             }
-            p = p + 2 * dx;
+            Chunk c;
+            c.begin = next;
+            c.end = stop;
+            pending.push_back(move(c));
+            next = stop;
+        }
+
+        vector<Chunk*> round;
+        for (Chunk& c : pending)
+            if (!c.done) round.push_back(&c);
+        atomic<size_t> nextChunk{ 0 };
+        auto worker = [&]() {
+            for (size_t i = nextChunk++; i < round.size(); i = nextChunk++) {
+                rasterizeChunk(*round[i], textOutput);
+                round[i]->done = true;
+            }
+        };
+        vector<thread> pool;
+        for (size_t t = 1; t < round.size(); ++t) pool.emplace_back(worker);
+        worker();
+        for (auto& th : pool) th.join();
+
+        // write in input order
+        while (!pending.empty()) {
+            Chunk& c = pending.front();
+            if (c.error) {
+                size_t offset = (size_t)(c.error - base);
+                size_t line = 1 + (size_t)count(base, c.error, '\n');
+                cerr << c.errorWhat << " at line " << line << " (byte " << offset << ")\n";
+                fclose(out);
+                return 1;
+            }
+            if (textOutput) fwrite(c.text.data(), 1, c.text.size(), out);
+            else fwrite(c.packed.data(), sizeof(int32_t), c.packed.size(), out);
+            segments += c.segments;
+            points += c.points;
+            if (!c.resume) {
+                pending.pop_front();
+                continue;
+            }
+
+            // a segment larger than the budget on its own is streamed here, on this thread
+            const char* p = c.resume;
+            const char* eol = lineEnd(p, c.end);
+            int v[4];
+            parseLine(p, eol, v); // already parsed as a valid segment
+            const int64_t n = segmentPoints(v);
+            if (segmentOutputBytes(n, textOutput) > CHUNK_OUTPUT_BYTES) {
+                StreamingPointSink sink{ out, textOutput, {} };
+                if (!textOutput) {
+                    const int32_t header = (int32_t)n;
+                    fwrite(&header, sizeof header, 1, out);
+                }
+                raster::lineBresenhamMajorAxisOctant(sink, v[0], v[1], v[2], v[3]);
+                if (textOutput) sink.buffer.push_back('\n');
+                sink.flush();
+                points += (uint64_t)n;
+                ++segments;
+                p = eol < c.end ? eol + 1 : eol;
+            }
+            Chunk rest;
+            rest.begin = p;
+            rest.end = c.end;
+            c = move(rest);
+            break;
         }
     }
+    fclose(out);
+
+    double s = chrono::duration<double>(clock::now() - t0).count();
+    if (s <= 0.0) s = 1e-9;
+    cerr << "segments: " << segments << "  points: " << points << "  threads: " << threads
+         << "  time: " << s << " s\n"
+         << "throughput: " << (uint64_t)(segments / s) << " segments/s  "
+         << (uint64_t)(points / s) << " points/s\n";
+    return 0;
 }
 
-int main() {
+int main(int argc, char** argv) {
+    if (argc > 1) {
+        if (strcmp(argv[1], "--batch") != 0 || argc < 4) {
+            cerr << "Usage: " << argv[0] << " [--batch in.txt out.bin [--text] [--threads N]]\n";
+            return 1;
+        }
+        bool textOutput = false;
+        unsigned threads = max(1u, thread::hardware_concurrency());
+        for (int i = 4; i < argc; ++i) {
+            if (strcmp(argv[i], "--text") == 0) textOutput = true;
+            else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) threads = (unsigned)max(1, atoi(argv[++i]));
+            else {
+                cerr << "unknown option: " << argv[i] << "\n";
+                return 1;
+            }
+        }
+        return runBatch(argv[2], argv[3], textOutput, threads);
+    }
+
     int x0, y0, x1, y1;
 
     cout << "Enter x0 y0: ";
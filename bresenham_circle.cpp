@@ -1,42 +1,16 @@
 #include <GL/glut.h>
 #include <iostream>
+#include "raster.h"
 using namespace std;
 
 int centerX, centerY, radius;
 
-void plotCirclePoints(int xc, int yc, int x, int y) {
-    glBegin(GL_POINTS);
-    glVertex2i(xc + x, yc + y);
-    glVertex2i(xc - x, yc + y);
-    glVertex2i(xc + x, yc - y);
-    glVertex2i(xc - x, yc - y);
-    glVertex2i(xc + y, yc + x);
-    glVertex2i(xc - y, yc + x);
-    glVertex2i(xc + y, yc - x);
-    glVertex2i(xc - y, yc - x);
-    glEnd();
-}
-
-void drawCircleBresenham(int xc, int yc, int r) {
-    int x = 0, y = r;
-    int d = 3 - 2 * r;
-
-    while (x <= y) {
-        plotCirclePoints(xc, yc, x, y);
-        if (d < 0)
-            d += 4 * x + 6;
-        else {
-            d += 4 * (x - y) + 10;
-            y--;
-        }
-        x++;
-    }
-}
-
 void display() {
     glClear(GL_COLOR_BUFFER_BIT);
     glColor3f(1, 1, 1); 
-    drawCircleBresenham(centerX, centerY, radius);
+    glBegin(GL_POINTS);
+    raster::circleBresenham(raster::GLPointSink{}, centerX, centerY, radius);
+    glEnd();
     glFlush();
 }
 
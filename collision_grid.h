@@ -0,0 +1,54 @@
+// collision_grid.h
+// Uniform grid broadphase over screen space.
+// Items are inserted by their AABB into every cell the box overlaps, and a query visits the
+// items of every cell its box overlaps, so an item can be visited more than once. Boxes
+// outside the grid clamp to the border cells, so off-screen objects are still found.
+// Cell vectors keep their capacity across clear(), so a per-frame rebuild does not allocate
+// once the game has warmed up.
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+struct UniformGrid {
+    float cellSize = 64.0f;
+    int cols = 0;
+    int rows = 0;
+    std::vector<std::vector<int>> cells;
+
+    // cover [0, width] x [0, height] with square cells
+    void reset(float width, float height, float cell) {
+        cellSize = cell;
+        cols = std::max(1, (int)std::ceil(width / cell));
+        rows = std::max(1, (int)std::ceil(height / cell));
+        cells.resize((size_t)cols * rows);
+        clear();
+    }
+
+    void clear() {
+        for (auto& c : cells) c.clear();
+    }
+
+    int cellX(float x) const { return std::min(cols - 1, std::max(0, (int)std::floor(x / cellSize))); }
+    int cellY(float y) const { return std::min(rows - 1, std::max(0, (int)std::floor(y / cellSize))); }
+
+    void insert(int id, float minX, float minY, float maxX, float maxY) {
+        int cx0 = cellX(minX), cx1 = cellX(maxX);
+        int cy0 = cellY(minY), cy1 = cellY(maxY);
+        for (int cy = cy0; cy <= cy1; ++cy)
+            for (int cx = cx0; cx <= cx1; ++cx)
+                cells[(size_t)cy * cols + cx].push_back(id);
+    }
+
+    // visit(id) for every item stored in a cell overlapped by the box (duplicates possible)
+    template <class Visit>
+    void query(float minX, float minY, float maxX, float maxY, Visit&& visit) const {
+        int cx0 = cellX(minX), cx1 = cellX(maxX);
+        int cy0 = cellY(minY), cy1 = cellY(maxY);
+        for (int cy = cy0; cy <= cy1; ++cy)
+            for (int cx = cx0; cx <= cx1; ++cx)
+                for (int id : cells[(size_t)cy * cols + cx]) visit(id);
+    }
+};
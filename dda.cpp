@@ -1,22 +1,12 @@
 #include <GL/glut.h>
-#include <math.h>
+#include "raster.h"
 
 void display() {
     glClear(GL_COLOR_BUFFER_BIT);
-    float x1 = 20, y1 = 30, x2 = 200, y2 = 180;
-    float dx = x2 - x1;
-    float dy = y2 - y1;
-    float steps = fabs(dx) > fabs(dy) ? fabs(dx) : fabs(dy);
-    float x_inc = dx / steps;
-    float y_inc = dy / steps;
-    float x = x1, y = y1;
+    int x1 = 20, y1 = 30, x2 = 200, y2 = 180;
 
     glBegin(GL_POINTS);
-    for (int i = 0; i <= steps; i++) {
-        glVertex2i(round(x), round(y));
-        x += x_inc;
-        y += y_inc;
-    }
+    raster::lineDDAFixed(raster::GLPointSink{}, x1, y1, x2, y2);
     glEnd();
     glFlush();
 }
@@ -0,0 +1,125 @@
+// dirty_rects.h
+// Dirty-region tracking for incremental redraws of a CPU framebuffer.
+//
+// Every drawn element is described by its screen bounding box and a signature of
+// everything that affects its pixels (position, size, colors). Comparing this frame's
+// elements with last frame's gives the regions that changed: the old box of every element
+// that moved, changed or vanished and the new box of every element that appeared. Those
+// boxes are marked on a coarse tile grid and the marked tiles are merged into a few
+// disjoint rectangles; only those are restored from the background and re-rasterized,
+// with the framebuffer clipped to each rectangle in turn.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Inclusive integer rectangle
+struct IRect {
+    int x0, y0, x1, y1;
+
+    bool empty() const { return x1 < x0 || y1 < y0; }
+    bool overlaps(const IRect& o) const { return x0 <= o.x1 && o.x0 <= x1 && y0 <= o.y1 && o.y0 <= y1; }
+    long long area() const { return empty() ? 0 : (long long)(x1 - x0 + 1) * (y1 - y0 + 1); }
+};
+
+// Fold one value into a 64-bit signature
+inline uint64_t hashMix(uint64_t h, uint64_t v) {
+    h ^= v + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+    h *= 0xff51afd7ed558ccdull;
+    return h ^ (h >> 33);
+}
+
+// One drawn element: where it is and what it looks like
+struct DrawItem {
+    IRect box;
+    uint64_t sig;
+};
+
+inline void sortBySig(std::vector<DrawItem>& items) {
+    std::sort(items.begin(), items.end(), [](const DrawItem& a, const DrawItem& b) { return a.sig < b.sig; });
+}
+
+struct DirtyRegion {
+    int width = 0, height = 0;
+    int tile = 16;
+    int cols = 0, rows = 0;
+    std::vector<uint8_t> marked;
+    std::vector<IRect> rects; // result of build(), disjoint
+    long long pixels = 0;     // total area of rects
+
+    void reset(int w, int h, int tileSize) {
+        width = w; height = h; tile = tileSize;
+        cols = (w + tile - 1) / tile;
+        rows = (h + tile - 1) / tile;
+        marked.assign((size_t)cols * rows, 0);
+        rects.clear();
+        pixels = 0;
+    }
+
+    void clear() { std::fill(marked.begin(), marked.end(), 0); }
+
+    void markAll() { std::fill(marked.begin(), marked.end(), 1); }
+
+    // mark the tiles under r (clamped to the screen)
+    void add(const IRect& r) {
+        if (r.empty() || r.x1 < 0 || r.y1 < 0 || r.x0 >= width || r.y0 >= height) return;
+        int c0 = std::max(0, r.x0) / tile, c1 = std::min(width - 1, r.x1) / tile;
+        int r0 = std::max(0, r.y0) / tile, r1 = std::min(height - 1, r.y1) / tile;
+        for (int ty = r0; ty <= r1; ++ty)
+            std::fill_n(marked.begin() + (size_t)ty * cols + c0, c1 - c0 + 1, (uint8_t)1);
+    }
+
+    // Mark everything that differs between two frames' element lists, both ordered by
+    // sortBySig: the box of every element present in only one of them
+    void addChanges(const std::vector<DrawItem>& prev, const std::vector<DrawItem>& cur) {
+        size_t i = 0, j = 0;
+        while (i < prev.size() || j < cur.size()) {
+            if (j == cur.size() || (i < prev.size() && prev[i].sig < cur[j].sig)) add(prev[i++].box);
+            else if (i == prev.size() || cur[j].sig < prev[i].sig) add(cur[j++].box);
+            else { ++i; ++j; } // unchanged
+        }
+    }
+
+    // Merge marked tiles into rectangles: runs of tiles per tile row, stacked with the run
+    // of the same columns on the rows above. When more than fullThreshold of the screen is
+    // dirty a single full-screen rectangle is cheaper than many small ones.
+    void build(double fullThreshold = 0.5) {
+        rects.clear();
+        pixels = 0;
+        size_t count = (size_t)std::count(marked.begin(), marked.end(), (uint8_t)1);
+        if (count == 0) return;
+        if (count > fullThreshold * marked.size()) {
+            rects.push_back({ 0, 0, width - 1, height - 1 });
+            pixels = (long long)width * height;
+            return;
+        }
+        size_t open = 0; // rects before this index can no longer grow
+        for (int ty = 0; ty < rows; ++ty) {
+            const uint8_t* m = marked.data() + (size_t)ty * cols;
+            size_t rowStart = rects.size();
+            int c = 0;
+            while (c < cols) {
+                if (!m[c]) { ++c; continue; }
+                int c0 = c;
+                while (c < cols && m[c]) ++c;
+                IRect r = { c0 * tile, ty * tile, std::min(width, c * tile) - 1, std::min(height, (ty + 1) * tile) - 1 };
+                // extend a rectangle from the previous tile row with exactly these columns
+                bool merged = false;
+                for (size_t k = open; k < rowStart; ++k) {
+                    if (rects[k].x0 == r.x0 && rects[k].x1 == r.x1 && rects[k].y1 == r.y0 - 1) {
+                        rects[k].y1 = r.y1;
+                        merged = true;
+                        break;
+                    }
+                }
+                if (!merged) rects.push_back(r);
+            }
+            // only rectangles that reach this row can grow on the next one
+            const int rowBottom = std::min(height, (ty + 1) * tile) - 1;
+            while (open < rects.size() && rects[open].y1 != rowBottom) ++open;
+        }
+        for (const IRect& r : rects) pixels += r.area();
+    }
+};
@@ -0,0 +1,123 @@
+// entity_pool.h
+// Fixed-capacity entity storage with a free list, generation-counted handles and deferred
+// spawn/despawn command buffers.
+//
+// Slots never move, so an index stays valid for the whole frame and a handle
+// (index + generation) stays valid until its slot is actually recycled; a stale handle is
+// detected by its generation. Spawns and despawns requested while the game is iterating
+// are queued and applied at the frame boundary by applyCommands(), so nothing is added to
+// or removed from the storage mid-iteration. All storage, including the command buffers,
+// is sized once by reset(), so steady-state frames do not allocate.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+struct EntityHandle {
+    uint32_t index = 0;
+    uint32_t generation = 0; // 0 is never a live generation, so a default handle is invalid
+};
+
+// Slot bookkeeping shared by the AoS EntityPool and the SoA BubbleStore
+struct SlotAllocator {
+    std::vector<uint32_t> generation;
+    std::vector<uint8_t> occupied;
+    std::vector<int> freeList; // stack; the most recently released slot is reused first
+    int highWater = 0;         // one past the highest occupied slot
+    int live = 0;
+
+    void reset(int capacity) {
+        generation.assign(capacity, 1u);
+        occupied.assign(capacity, 0);
+        freeList.clear();
+        freeList.reserve(capacity);
+        for (int i = capacity - 1; i >= 0; --i) freeList.push_back(i);
+        highWater = 0;
+        live = 0;
+    }
+
+    int capacity() const { return (int)occupied.size(); }
+
+    // take a free slot, or -1 when the pool is full
+    int acquire() {
+        if (freeList.empty()) return -1;
+        int i = freeList.back();
+        freeList.pop_back();
+        occupied[i] = 1;
+        ++live;
+        if (i + 1 > highWater) highWater = i + 1;
+        return i;
+    }
+
+    void release(int i) {
+        occupied[i] = 0;
+        if (++generation[i] == 0) generation[i] = 1;
+        --live;
+        freeList.push_back(i);
+        while (highWater > 0 && !occupied[highWater - 1]) --highWater;
+    }
+
+    EntityHandle handle(int i) const { return { (uint32_t)i, generation[i] }; }
+
+    bool valid(EntityHandle h) const {
+        return h.index < occupied.size() && occupied[h.index] && generation[h.index] == h.generation;
+    }
+};
+
+// Array-of-structs pool for entities that are always touched as a whole (projectiles)
+template <class T>
+struct EntityPool {
+    std::vector<T> items;
+    SlotAllocator slots;
+    std::vector<T> pendingSpawns;
+    std::vector<EntityHandle> pendingDespawns;
+    uint64_t droppedSpawns = 0; // spawns that found the pool full
+
+    void reset(int capacity) {
+        items.assign(capacity, T{});
+        slots.reset(capacity);
+        pendingSpawns.clear();
+        pendingSpawns.reserve(capacity);
+        pendingDespawns.clear();
+        pendingDespawns.reserve(capacity);
+    }
+
+    // queue a new entity; it becomes visible after the next applyCommands()
+    void spawn(const T& v) {
+        if ((int)pendingSpawns.size() < slots.capacity()) pendingSpawns.push_back(v);
+        else ++droppedSpawns;
+    }
+
+    // queue removal; stale or repeated handles are ignored when the queue is applied
+    void despawn(EntityHandle h) {
+        if ((int)pendingDespawns.size() < slots.capacity()) pendingDespawns.push_back(h);
+    }
+
+    // frame boundary: free despawned slots first so spawns can reuse them
+    void applyCommands() {
+        for (EntityHandle h : pendingDespawns)
+            if (slots.valid(h)) slots.release((int)h.index);
+        pendingDespawns.clear();
+        for (const T& v : pendingSpawns) {
+            int i = slots.acquire();
+            if (i < 0) { ++droppedSpawns; continue; }
+            items[i] = v;
+        }
+        pendingSpawns.clear();
+    }
+
+    EntityHandle handle(int i) const { return slots.handle(i); }
+    bool valid(EntityHandle h) const { return slots.valid(h); }
+    T& operator[](int i) { return items[i]; }
+    const T& operator[](int i) const { return items[i]; }
+    int liveCount() const { return slots.live; }
+    int slotCount() const { return slots.highWater; }
+
+    // f(item, slotIndex) for every occupied slot, in slot order
+    template <class F>
+    void forEach(F&& f) {
+        for (int i = 0; i < slots.highWater; ++i)
+            if (slots.occupied[i]) f(items[i], i);
+    }
+};
@@ -0,0 +1,77 @@
+// framebuffer.h
+// Packed RGBA software framebuffer used as a CPU render target for the raster algorithms.
+// Rows are stored bottom-up (row 0 is y = 0) so the buffer matches the glOrtho pixel
+// coordinates used by the games and can be uploaded to a GL texture as-is.
+// Writes are clipped to a clip rectangle (the whole buffer unless setClip narrows it), so
+// a partial redraw can re-rasterize whole primitives without touching pixels outside it.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Pack a 0..1 float color into 32 bits. R is the low byte, so on little-endian machines
+// the bytes in memory read R, G, B, A and can be uploaded as GL_RGBA / GL_UNSIGNED_BYTE.
+inline uint32_t packRGBA(float r, float g, float b, float a = 1.0f) {
+    auto to8 = [](float v) -> uint32_t {
+        v = v < 0.0f ? 0.0f : (v > 1.0f ? 1.0f : v);
+        return (uint32_t)(v * 255.0f + 0.5f);
+    };
+    return to8(r) | (to8(g) << 8) | (to8(b) << 16) | (to8(a) << 24);
+}
+
+struct Framebuffer {
+    int width = 0;
+    int height = 0;
+    std::vector<uint32_t> pixels;
+    int clipX0 = 0, clipY0 = 0, clipX1 = -1, clipY1 = -1; // inclusive
+
+    void resize(int w, int h) {
+        width = w;
+        height = h;
+        pixels.assign((size_t)w * h, 0u);
+        resetClip();
+    }
+
+    // restrict setPixel / fillSpan to [x0, x1] x [y0, y1] (clamped to the buffer)
+    void setClip(int x0, int y0, int x1, int y1) {
+        clipX0 = std::max(x0, 0);
+        clipY0 = std::max(y0, 0);
+        clipX1 = std::min(x1, width - 1);
+        clipY1 = std::min(y1, height - 1);
+    }
+
+    void resetClip() { setClip(0, 0, width - 1, height - 1); }
+
+    void clear(uint32_t c) { std::fill(pixels.begin(), pixels.end(), c); }
+
+    bool inside(int x, int y) const {
+        return (unsigned)x < (unsigned)width && (unsigned)y < (unsigned)height;
+    }
+
+    bool insideClip(int x, int y) const {
+        return x >= clipX0 && x <= clipX1 && y >= clipY0 && y <= clipY1;
+    }
+
+    // write one pixel; anything outside the clip rectangle is dropped
+    void setPixel(int x, int y, uint32_t c) {
+        if (insideClip(x, y)) pixels[(size_t)y * width + x] = c;
+    }
+
+    // fill the horizontal run [x0, x1] on row y as one contiguous store, clipped to the clip rectangle
+    void fillSpan(int x0, int x1, int y, uint32_t c) {
+        if (y < clipY0 || y > clipY1) return;
+        if (x0 < clipX0) x0 = clipX0;
+        if (x1 > clipX1) x1 = clipX1;
+        if (x0 > x1) return;
+        std::fill_n(row(y) + x0, x1 - x0 + 1, c);
+    }
+
+    uint32_t getPixel(int x, int y) const {
+        return inside(x, y) ? pixels[(size_t)y * width + x] : 0u;
+    }
+
+    uint32_t* row(int y) { return pixels.data() + (size_t)y * width; }
+    const uint32_t* row(int y) const { return pixels.data() + (size_t)y * width; }
+};
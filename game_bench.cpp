@@ -0,0 +1,344 @@
+// game_bench.cpp
+// Headless benchmarks for the 2D shooter's simulation subsystems (no window, no GL).
+// Build: g++ -O2 -std=c++17 -mavx2 game_bench.cpp -o game_bench   (drop -mavx2 for the SSE2 kernel)
+// Run:   game_bench [--suite all|bubbles|sprites|tiles] [--min-time ms] [--out results.json]
+//
+// Suites:
+//   bubbles  per-frame bubble update: original array-of-structs loop vs the
+//            structure-of-arrays store (scalar and SIMD kernels) at 1k..1M bubbles
+//   sprites  drawing 10k on-screen bubbles into the 900x700 framebuffer: rasterizing every
+//            layer each frame vs blitting tinted masks from the sprite cache (warm, and
+//            under a ceiling too small to hold every radius)
+//   tiles    one full frame of large bubbles over the grid, with the launcher, aim line and
+//            HUD: drawn in order on one thread vs recorded into the tiled renderer and
+//            rasterized on 1, 2, 4, ... threads (up to the core count, at least 8); every
+//            variant is checked pixel for pixel against the single-threaded frame. Threads
+//            beyond the core count only measure the cost of oversubscribing them
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bubble_store.h"
+#include "framebuffer.h"
+#include "sprite_cache.h"
+#include "tile_renderer.h"
+
+using namespace std;
+
+struct Result {
+    string suite;
+    string variant;
+    int count;           // entities per frame
+    double nsPerFrame;
+    double nsPerEntity;
+    string note;         // free-form extra JSON fields (already formatted), may be empty
+};
+
+double minSeconds = 0.2;
+
+// Run setup() untimed then body() timed, until minSeconds of body time; keep the fastest pass
+template <class Setup, class Body>
+double bestSeconds(Setup&& setup, Body&& body) {
+    using clock = chrono::steady_clock;
+    double best = 1e30, total = 0.0;
+    int passes = 0;
+    while (total < minSeconds || passes < 3) {
+        setup();
+        auto t0 = clock::now();
+        body();
+        double s = chrono::duration<double>(clock::now() - t0).count();
+        best = min(best, s);
+        total += s;
+        ++passes;
+    }
+    return best;
+}
+
+// ----- bubbles suite -----
+
+const int SCR_W = 900;
+const int SCR_H = 700;
+const BubbleBounds BOUNDS = { 30.0f, (float)(SCR_W - 30), -50.0f };
+
+// Bubbles scattered over the screen with the game's spawn velocities; about 1 in 16 dead
+vector<Bubble> makeBubbles(int n, unsigned seed) {
+    mt19937 rng(seed);
+    uniform_real_distribution<float> ux(0.0f, (float)SCR_W), uy(-40.0f, (float)SCR_H);
+    uniform_real_distribution<float> uvx(-0.5f, 0.5f), uvy(-0.6f, 0.4f), u01(0.0f, 1.0f);
+    vector<Bubble> v(n);
+    for (auto& b : v) {
+        b.x = ux(rng); b.y = uy(rng);
+        b.z = u01(rng) * 0.5f;
+        b.radius = 18.0f + u01(rng) * 18.0f;
+        b.vx = uvx(rng); b.vy = uvy(rng);
+        b.col = { u01(rng), u01(rng), u01(rng) };
+        b.alive = (rng() & 15) != 0;
+    }
+    return v;
+}
+
+void benchBubbles(vector<Result>& out) {
+    const int frames = 16;
+    const float dt = 1.0f / 60.0f;
+    for (int n : { 1000, 10000, 100000, 1000000 }) {
+        const vector<Bubble> init = makeBubbles(n, 1234u + n);
+        BubbleStore initStore;
+        initStore.reset(n);
+        for (const Bubble& b : init) initStore.push(b);
+
+        vector<Bubble> aos;
+        BubbleStore soa;
+        const string simdVariant = string("soa_simd_") + bubbleKernelName();
+        auto add = [&](const char* variant, double s) {
+            out.push_back({ "bubbles", variant, n, s * 1e9 / frames, s * 1e9 / frames / n, "" });
+        };
+        add("aos_loop", bestSeconds([&] { aos = init; }, [&] {
+            for (int f = 0; f < frames; ++f) updateBubblesAoS(aos, dt, BOUNDS);
+        }));
+        add("soa_scalar", bestSeconds([&] { soa = initStore; }, [&] {
+            for (int f = 0; f < frames; ++f) updateBubblesScalar(soa, 0, soa.slotCount(), dt, BOUNDS);
+        }));
+        add(simdVariant.c_str(), bestSeconds([&] { soa = initStore; }, [&] {
+            for (int f = 0; f < frames; ++f) updateBubblesSIMD(soa, dt, BOUNDS);
+        }));
+
+        // validation: both layouts must agree after the same frames
+        aos = init;
+        soa = initStore;
+        for (int f = 0; f < frames; ++f) {
+            updateBubblesAoS(aos, dt, BOUNDS);
+            updateBubblesSIMD(soa, dt, BOUNDS);
+        }
+        double maxDiff = 0.0;
+        int aliveMismatch = 0;
+        for (int i = 0; i < n; ++i) {
+            maxDiff = max(maxDiff, (double)fabsf(aos[i].x - soa.x[i]));
+            maxDiff = max(maxDiff, (double)fabsf(aos[i].y - soa.y[i]));
+            maxDiff = max(maxDiff, (double)fabsf(aos[i].vx - soa.vx[i]));
+            if (aos[i].alive != (soa.alive[i] != 0)) ++aliveMismatch;
+        }
+        char note[128];
+        snprintf(note, sizeof(note), "\"max_abs_diff\": %g, \"alive_mismatches\": %d", maxDiff, aliveMismatch);
+        out.back().note = note;
+        if (maxDiff > 1e-3 || aliveMismatch) cerr << "bubbles: SoA kernel disagrees with AoS loop at n=" << n << "\n";
+    }
+}
+
+// ----- sprites suite -----
+
+// What drawBubbleClassic derives from a bubble
+struct BubbleLook {
+    int xc, yc, r;
+    BubblePalette palette;
+};
+
+// Bubbles drawn with the game's spawn distribution (radius, depth, color) plus split bubbles
+vector<BubbleLook> makeLooks(int n, unsigned seed) {
+    mt19937 rng(seed);
+    vector<BubbleLook> v(n);
+    for (auto& b : v) {
+        float radius = (float)(rng() % 18 + 18);
+        if (rng() % 4 == 0) radius *= 0.6f; // split
+        float z = (float)(rng() % 100) / 200.0f;
+        float cr = 0.4f + (rng() % 60) / 150.0f, cg = 0.4f + (rng() % 60) / 150.0f, cb = 0.4f + (rng() % 60) / 150.0f;
+        b.xc = (int)(rng() % SCR_W);
+        b.yc = (int)(rng() % SCR_H);
+        b.r = (int)roundf(radius * (1.0f - z));
+        b.palette = { { packRGBA(cr, cg, cb), packRGBA(1.0f, 1.0f, 1.0f),
+                        packRGBA(max(0.0f, cr - 0.18f), max(0.0f, cg - 0.18f), max(0.0f, cb - 0.18f)) } };
+    }
+    return v;
+}
+
+void benchSprites(vector<Result>& out) {
+    const int n = 10000;
+    const int frames = 4;
+    const vector<BubbleLook> looks = makeLooks(n, 99u);
+    const uint32_t background = packRGBA(0.06f, 0.08f, 0.12f);
+    Framebuffer fb;
+    fb.resize(SCR_W, SCR_H);
+
+    auto drawDirect = [&] {
+        for (const BubbleLook& b : looks) rasterizeBubble(fb, b.xc, b.yc, b.r, b.palette);
+    };
+    auto drawCached = [&](BubbleSpriteCache& cache) {
+        for (const BubbleLook& b : looks) blitSprite(fb, cache.get(b.r), b.xc, b.yc, b.palette);
+    };
+    auto add = [&](const char* variant, double s, const string& note) {
+        out.push_back({ "sprites", variant, n, s * 1e9 / frames, s * 1e9 / frames / n, note });
+    };
+
+    add("direct_raster", bestSeconds([&] { fb.clear(background); }, [&] {
+        for (int f = 0; f < frames; ++f) drawDirect();
+    }), "");
+    fb.clear(background);
+    drawDirect();
+    const vector<uint32_t> reference = fb.pixels;
+
+    // the default game ceiling holds every radius; 16 KB does not, so the LRU has to evict
+    for (size_t ceiling : { (size_t)16 << 20, (size_t)16 << 10 }) {
+        BubbleSpriteCache cache;
+        cache.setCapacity(ceiling);
+        fb.clear(background);
+        drawCached(cache); // warm-up frame; also the validation frame
+        long long mismatches = 0;
+        for (size_t i = 0; i < fb.pixels.size(); ++i) mismatches += fb.pixels[i] != reference[i];
+        cache.stats.hits = cache.stats.misses = cache.stats.evictions = 0;
+
+        double s = bestSeconds([&] { fb.clear(background); }, [&] {
+            for (int f = 0; f < frames; ++f) drawCached(cache);
+        });
+        const SpriteCacheStats& cs = cache.stats;
+        char note[256];
+        snprintf(note, sizeof(note),
+            "\"ceiling_kb\": %zu, \"hit_rate\": %.4f, \"evictions\": %llu, \"entries\": %zu, \"cache_kb\": %zu, \"pixel_mismatches\": %lld",
+            ceiling / 1024, cs.hitRate(), (unsigned long long)cs.evictions, cs.entries, cs.bytes / 1024, mismatches);
+        add(ceiling >= ((size_t)16 << 20) ? "sprite_cache" : "sprite_cache_16kb", s, note);
+        if (mismatches) cerr << "sprites: cached bubbles differ from direct rasterization (" << mismatches << " pixels)\n";
+    }
+}
+
+// ----- tiles suite -----
+
+void benchTiles(vector<Result>& out) {
+    const int n = 600;
+    vector<BubbleLook> looks = makeLooks(n, 7u);
+    for (BubbleLook& b : looks) b.r *= 2; // large bubbles: the frame is mostly fill
+    const uint32_t gridColor = packRGBA(0.08f, 0.1f, 0.15f);
+    const uint32_t launcher = packRGBA(0.2f, 0.2f, 0.25f), barrel = packRGBA(0.85f, 0.85f, 0.9f);
+    const uint32_t aim = packRGBA(0.9f, 0.6f, 0.2f), hud = packRGBA(0.9f, 0.9f, 0.2f);
+    const int gunX = SCR_W / 2, gunY = 40, aimX = 700, aimY = 650;
+
+    Framebuffer background;
+    background.resize(SCR_W, SCR_H);
+    background.clear(packRGBA(0.06f, 0.08f, 0.12f));
+    {
+        raster::FramebufferSink grid{ background, gridColor };
+        for (int gx = 0; gx <= SCR_W; gx += 60) raster::lineDDA(grid, gx, 0, gx, SCR_H);
+        for (int gy = 0; gy <= SCR_H; gy += 60) raster::lineDDA(grid, 0, gy, SCR_W, gy);
+    }
+    Framebuffer fb;
+    fb.resize(SCR_W, SCR_H);
+
+    // the 2D shooter's scene, in its draw order, on one thread
+    auto drawSerial = [&] {
+        fb.pixels = background.pixels;
+        for (const BubbleLook& b : looks) rasterizeBubble(fb, b.xc, b.yc, b.r, b.palette);
+        raster::fillCircleMidpoint(raster::FramebufferSink{ fb, launcher }, gunX, gunY, 10);
+        raster::thickLine(raster::FramebufferSink{ fb, barrel }, gunX, gunY, gunX + 22, gunY + 33, 3.0f);
+        raster::dashedLineDDAFixed(raster::FramebufferSink{ fb, aim }, gunX, gunY, aimX, aimY, 8);
+        raster::fillRect(raster::FramebufferSink{ fb, hud }, 12, SCR_H - 31, 17, SCR_H - 20);
+    };
+    // the same scene recorded into tiles
+    auto record = [&](TileRenderer& tiles) {
+        tiles.begin(SCR_W, SCR_H);
+        for (const BubbleLook& b : looks) {
+            tiles.disc(b.xc, b.yc, b.r, b.palette.layer[BubblePalette::FILL]);
+            tiles.disc(b.xc - b.r / 3, b.yc + b.r / 3, max(1, b.r / 6), b.palette.layer[BubblePalette::HIGHLIGHT]);
+            tiles.circle(b.xc, b.yc, b.r, b.palette.layer[BubblePalette::OUTLINE]);
+        }
+        tiles.disc(gunX, gunY, 10, launcher);
+        tiles.thickLine(gunX, gunY, gunX + 22, gunY + 33, 3.0f, raster::LineCap::Butt, barrel);
+        tiles.dashedLineDDA(gunX, gunY, aimX, aimY, 8, aim);
+        tiles.rect(12, SCR_H - 31, 17, SCR_H - 20, hud);
+    };
+    const vector<IRect> fullScreen = { { 0, 0, SCR_W - 1, SCR_H - 1 } };
+    const int cores = max(1, (int)thread::hardware_concurrency());
+    auto add = [&](const string& variant, double s, const string& note) {
+        out.push_back({ "tiles", variant, n, s * 1e9, s * 1e9 / n, note });
+    };
+
+    const double serial = bestSeconds([] {}, drawSerial);
+    drawSerial();
+    const vector<uint32_t> reference = fb.pixels;
+    char note[256];
+    snprintf(note, sizeof(note), "\"threads\": 1, \"cores\": %d, \"speedup\": 1.00", cores);
+    add("serial", serial, note);
+
+    TileRenderer tiles;
+    for (int threads = 1; threads <= max(cores, 8); threads *= 2) {
+        tiles.pool.resize(threads);
+        fb.clear(0u);
+        record(tiles);
+        tiles.render(fb, &background, fullScreen);
+        long long mismatches = 0;
+        for (size_t i = 0; i < fb.pixels.size(); ++i) mismatches += fb.pixels[i] != reference[i];
+        const uint64_t steals0 = tiles.pool.steals();
+        int passes = 0;
+        double s = bestSeconds([] {}, [&] {
+            record(tiles);
+            tiles.render(fb, &background, fullScreen);
+            ++passes;
+        });
+        snprintf(note, sizeof(note),
+            "\"threads\": %d, \"cores\": %d, \"speedup\": %.2f, \"tiles\": %zu, \"steals_per_frame\": %.1f, \"pixel_mismatches\": %lld",
+            threads, cores, serial / s, tiles.jobs.size(), (double)(tiles.pool.steals() - steals0) / passes, mismatches);
+        add("tiled_" + to_string(threads) + "t", s, note);
+        if (mismatches) cerr << "tiles: " << threads << "-thread frame differs from the serial one (" << mismatches << " pixels)\n";
+    }
+}
+
+// ----- report -----
+
+void writeJson(ostream& os, const vector<Result>& results) {
+    os << "{\n";
+    os << "  \"benchmark\": \"game_bench\",\n";
+    os << "  \"bubble_kernel\": \"" << bubbleKernelName() << "\",\n";
+    os << "  \"min_time_ms\": " << minSeconds * 1000.0 << ",\n";
+    os << "  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        char buf[512];
+        snprintf(buf, sizeof(buf),
+            "    {\"suite\": \"%s\", \"variant\": \"%s\", \"count\": %d, "
+            "\"ns_per_frame\": %.1f, \"ns_per_entity\": %.3f%s%s}%s\n",
+            r.suite.c_str(), r.variant.c_str(), r.count, r.nsPerFrame, r.nsPerEntity,
+            r.note.empty() ? "" : ", ", r.note.c_str(), i + 1 < results.size() ? "," : "");
+        os << buf;
+    }
+    os << "  ]\n";
+    os << "}\n";
+}
+
+int main(int argc, char** argv) {
+    string suite = "all";
+    string outPath;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--suite") == 0 && i + 1 < argc) suite = argv[++i];
+        else if (strcmp(argv[i], "--min-time") == 0 && i + 1 < argc) minSeconds = atof(argv[++i]) / 1000.0;
+        else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) outPath = argv[++i];
+        else {
+            cerr << "Usage: " << argv[0] << " [--suite all|bubbles|sprites|tiles] [--min-time ms] [--out file.json]\n";
+            return 1;
+        }
+    }
+
+    vector<Result> results;
+    bool any = false;
+    if (suite == "all" || suite == "bubbles") { benchBubbles(results); any = true; }
+    if (suite == "all" || suite == "sprites") { benchSprites(results); any = true; }
+    if (suite == "all" || suite == "tiles") { benchTiles(results); any = true; }
+    if (!any) {
+        cerr << "unknown suite: " << suite << "\n";
+        return 1;
+    }
+
+    if (outPath.empty()) {
+        writeJson(cout, results);
+    }
+    else {
+        ofstream f(outPath);
+        if (!f) { cerr << "cannot write " << outPath << "\n"; return 1; }
+        writeJson(f, results);
+        cerr << "wrote " << results.size() << " results to " << outPath << "\n";
+    }
+    return 0;
+}
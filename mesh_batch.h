@@ -0,0 +1,241 @@
+// mesh_batch.h
+// Retained meshes and CPU instance batching for the 3D shooter's fixed-function renderer.
+//
+// Meshes (sphere, cube, cylinder) are tessellated once at startup. Each frame the instances
+// of one mesh are expanded into a single vertex/index stream (position, normal, RGBA color)
+// that the GL client arrays read directly, so a whole mesh type is submitted with one
+// glDrawElements call instead of one glut/GLU call per object. The per-instance transforms
+// are the ones the game needs: a translation, optionally with a spin about the Y axis.
+// Index streams only depend on the mesh and the instance count, so they are generated once
+// and reused while the mesh stays the same; all vectors keep their capacity across frames.
+// Nothing here calls GL, so the batching can be exercised without a context.
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+struct MeshVertex {
+    float px, py, pz;
+    float nx, ny, nz;
+};
+
+// Indexed triangle list with outward normals (counter-clockwise front faces)
+struct Mesh {
+    std::vector<MeshVertex> vertices;
+    std::vector<uint32_t> indices;
+};
+
+// Layout read by glVertexPointer / glNormalPointer / glColorPointer
+struct BatchVertex {
+    float px, py, pz;
+    float nx, ny, nz;
+    uint8_t r, g, b, a;
+};
+
+inline uint8_t colorByte(float c) {
+    return (uint8_t)(c <= 0.0f ? 0 : c >= 1.0f ? 255 : (int)(c * 255.0f + 0.5f));
+}
+
+// ----- Mesh builders -----
+
+// UV sphere centered at the origin (same slice/stack layout as glutSolidSphere)
+inline Mesh makeSphereMesh(float radius, int slices, int stacks) {
+    Mesh m;
+    const float pi = 3.14159265358979f;
+    for (int i = 0; i <= stacks; ++i) {
+        float phi = pi * i / stacks; // 0 at +z pole
+        float sp = sinf(phi), cp = cosf(phi);
+        for (int j = 0; j <= slices; ++j) {
+            float theta = 2.0f * pi * j / slices;
+            float nx = sp * cosf(theta), ny = sp * sinf(theta), nz = cp;
+            m.vertices.push_back({ nx * radius, ny * radius, nz * radius, nx, ny, nz });
+        }
+    }
+    const uint32_t row = (uint32_t)slices + 1;
+    for (int i = 0; i < stacks; ++i) {
+        for (int j = 0; j < slices; ++j) {
+            uint32_t a = i * row + j, b = a + row;
+            // degenerate triangles at the poles are skipped
+            if (i != 0) { m.indices.push_back(a); m.indices.push_back(b); m.indices.push_back(a + 1); }
+            if (i != stacks - 1) { m.indices.push_back(a + 1); m.indices.push_back(b); m.indices.push_back(b + 1); }
+        }
+    }
+    return m;
+}
+
+// Axis-aligned cube of edge `size` centered at the origin; each face is split into
+// subdiv x subdiv quads (more vertices give smoother per-vertex lighting up close)
+inline Mesh makeCubeMesh(float size, int subdiv = 1) {
+    Mesh m;
+    const float h = size * 0.5f;
+    // face normal and the two in-plane axes, ordered so u x v = n
+    const float faces[6][9] = {
+        { 1, 0, 0,   0, 0, -1,  0, 1, 0 },
+        { -1, 0, 0,  0, 0, 1,   0, 1, 0 },
+        { 0, 1, 0,   1, 0, 0,   0, 0, -1 },
+        { 0, -1, 0,  1, 0, 0,   0, 0, 1 },
+        { 0, 0, 1,   1, 0, 0,   0, 1, 0 },
+        { 0, 0, -1,  -1, 0, 0,  0, 1, 0 },
+    };
+    for (const auto& f : faces) {
+        uint32_t base = (uint32_t)m.vertices.size();
+        for (int i = 0; i <= subdiv; ++i) {
+            float v = -h + size * i / subdiv;
+            for (int j = 0; j <= subdiv; ++j) {
+                float u = -h + size * j / subdiv;
+                m.vertices.push_back({ f[0] * h + f[3] * u + f[6] * v,
+                                       f[1] * h + f[4] * u + f[7] * v,
+                                       f[2] * h + f[5] * u + f[8] * v,
+                                       f[0], f[1], f[2] });
+            }
+        }
+        const uint32_t row = (uint32_t)subdiv + 1;
+        for (int i = 0; i < subdiv; ++i) {
+            for (int j = 0; j < subdiv; ++j) {
+                uint32_t a = base + i * row + j, b = a + row;
+                m.indices.insert(m.indices.end(), { a, a + 1, b + 1, a, b + 1, b });
+            }
+        }
+    }
+    return m;
+}
+
+// Open cylinder along +z from 0 to height (same placement as gluCylinder)
+inline Mesh makeCylinderMesh(float radius, float height, int slices) {
+    Mesh m;
+    const float pi = 3.14159265358979f;
+    for (int j = 0; j <= slices; ++j) {
+        float theta = 2.0f * pi * j / slices;
+        float nx = sinf(theta), ny = cosf(theta);
+        m.vertices.push_back({ nx * radius, ny * radius, 0.0f, nx, ny, 0.0f });
+        m.vertices.push_back({ nx * radius, ny * radius, height, nx, ny, 0.0f });
+    }
+    for (int j = 0; j < slices; ++j) {
+        uint32_t a = 2 * j, b = a + 2;
+        m.indices.insert(m.indices.end(), { a, b + 1, b, a, a + 1, b + 1 });
+    }
+    return m;
+}
+
+// ----- Affine transforms (for baking static parts) -----
+
+// Row-major 3x4 matrix: p' = M * (p, 1)
+struct Affine {
+    float m[12] = { 1, 0, 0, 0,  0, 1, 0, 0,  0, 0, 1, 0 };
+
+    static Affine translate(float x, float y, float z) {
+        Affine a;
+        a.m[3] = x; a.m[7] = y; a.m[11] = z;
+        return a;
+    }
+    static Affine scale(float x, float y, float z) {
+        Affine a;
+        a.m[0] = x; a.m[5] = y; a.m[10] = z;
+        return a;
+    }
+    static Affine rotateX(float deg) {
+        Affine a;
+        float r = deg * 3.14159265358979f / 180.0f, c = cosf(r), s = sinf(r);
+        a.m[5] = c; a.m[6] = -s; a.m[9] = s; a.m[10] = c;
+        return a;
+    }
+
+    // this * o, i.e. o is applied first (same order as consecutive glTranslate/glRotate/glScale)
+    Affine operator*(const Affine& o) const {
+        Affine r;
+        for (int i = 0; i < 3; ++i) {
+            for (int j = 0; j < 4; ++j) {
+                float v = m[i * 4] * o.m[j] + m[i * 4 + 1] * o.m[4 + j] + m[i * 4 + 2] * o.m[8 + j];
+                r.m[i * 4 + j] = v + (j == 3 ? m[i * 4 + 3] : 0.0f);
+            }
+        }
+        return r;
+    }
+};
+
+// General indexed vertex stream; used for meshes assembled once from several parts
+struct DrawList {
+    std::vector<BatchVertex> vertices;
+    std::vector<uint32_t> indices;
+
+    void clear() { vertices.clear(); indices.clear(); }
+
+    // append mesh transformed by xf; normals use the cofactor (inverse-transpose) matrix so
+    // they stay perpendicular under non-uniform scale
+    void append(const Mesh& mesh, const Affine& xf, float r, float g, float b) {
+        const float* m = xf.m;
+        const float c[9] = {
+            m[5] * m[10] - m[6] * m[9], m[6] * m[8] - m[4] * m[10], m[4] * m[9] - m[5] * m[8],
+            m[2] * m[9] - m[1] * m[10], m[0] * m[10] - m[2] * m[8], m[1] * m[8] - m[0] * m[9],
+            m[1] * m[6] - m[2] * m[5], m[2] * m[4] - m[0] * m[6], m[0] * m[5] - m[1] * m[4],
+        };
+        const uint8_t cr = colorByte(r), cg = colorByte(g), cb = colorByte(b);
+        const uint32_t base = (uint32_t)vertices.size();
+        for (const MeshVertex& v : mesh.vertices) {
+            BatchVertex o;
+            o.px = m[0] * v.px + m[1] * v.py + m[2] * v.pz + m[3];
+            o.py = m[4] * v.px + m[5] * v.py + m[6] * v.pz + m[7];
+            o.pz = m[8] * v.px + m[9] * v.py + m[10] * v.pz + m[11];
+            float nx = c[0] * v.nx + c[1] * v.ny + c[2] * v.nz;
+            float ny = c[3] * v.nx + c[4] * v.ny + c[5] * v.nz;
+            float nz = c[6] * v.nx + c[7] * v.ny + c[8] * v.nz;
+            float len = sqrtf(nx * nx + ny * ny + nz * nz);
+            if (len > 0.0f) { nx /= len; ny /= len; nz /= len; }
+            o.nx = nx; o.ny = ny; o.nz = nz;
+            o.r = cr; o.g = cg; o.b = cb; o.a = 255;
+            vertices.push_back(o);
+        }
+        for (uint32_t i : mesh.indices) indices.push_back(base + i);
+    }
+};
+
+// ----- Per-frame instancing -----
+
+// All instances of one mesh for one frame: begin(), add...() per object, then draw
+// indexCount() indices from indices.data() against vertices.data()
+struct InstanceBatch {
+    const Mesh* mesh = nullptr;
+    std::vector<BatchVertex> vertices;
+    std::vector<uint32_t> indices; // pattern for indexedInstances instances of `mesh`
+    int instances = 0;
+    int indexedInstances = 0;
+
+    void begin(const Mesh& m) {
+        if (mesh != &m) { mesh = &m; indices.clear(); indexedInstances = 0; }
+        vertices.clear();
+        instances = 0;
+    }
+
+    // translated copy (spheres: orientation does not matter)
+    void add(float x, float y, float z, float r, float g, float b) {
+        const uint8_t cr = colorByte(r), cg = colorByte(g), cb = colorByte(b);
+        for (const MeshVertex& v : mesh->vertices)
+            vertices.push_back({ v.px + x, v.py + y, v.pz + z, v.nx, v.ny, v.nz, cr, cg, cb, 255 });
+        ++instances;
+    }
+
+    // copy rotated by yawDeg about +Y (as glRotatef(yawDeg, 0, 1, 0)), then translated
+    void addYaw(float x, float y, float z, float yawDeg, float r, float g, float b) {
+        const uint8_t cr = colorByte(r), cg = colorByte(g), cb = colorByte(b);
+        float a = yawDeg * 3.14159265358979f / 180.0f, c = cosf(a), s = sinf(a);
+        for (const MeshVertex& v : mesh->vertices) {
+            vertices.push_back({ c * v.px + s * v.pz + x, v.py + y, -s * v.px + c * v.pz + z,
+                                 c * v.nx + s * v.nz, v.ny, -s * v.nx + c * v.nz, cr, cg, cb, 255 });
+        }
+        ++instances;
+    }
+
+    // extend the cached index pattern to cover every instance added this frame
+    void finish() {
+        if (instances <= indexedInstances) return;
+        const uint32_t stride = (uint32_t)mesh->vertices.size();
+        indices.reserve((size_t)instances * mesh->indices.size());
+        for (int k = indexedInstances; k < instances; ++k)
+            for (uint32_t i : mesh->indices) indices.push_back(k * stride + i);
+        indexedInstances = instances;
+    }
+
+    size_t indexCount() const { return (size_t)instances * (mesh ? mesh->indices.size() : 0); }
+};
@@ -0,0 +1,226 @@
+// profiler.h
+// Per-stage frame profiler for the game loops: scoped timers feed per-stage frame-time
+// histograms (p50/p95/p99) and, optionally, a Chrome trace-event JSON file
+// (chrome://tracing or https://ui.perfetto.dev).
+//
+// A game names its stages once (setStages) and wraps each one in a ProfileScope. The time
+// of every scope is added to its stage's total for the current frame; endFrame() moves
+// those totals into the histograms, so a stage entered several times in one frame (once per
+// dirty rectangle, say) still yields one sample per frame. Scopes may nest; a stage's time
+// includes the stages nested in it. Each stage must only be timed from one thread, and
+// that thread calls endFrame for its own range of stages.
+//
+// Disabled (the default), a scope is one branch on a plain bool and endFrame returns at
+// once, so the timers can stay compiled into release builds. Histograms are log-linear
+// (8 buckets per power of two, so percentiles are within about 6%) with atomic counters that
+// can be read from any thread. Trace events go to a per-thread buffer capped at
+// maxTraceEvents; the file is written from those buffers at exit.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+struct StageHistogram {
+    static constexpr int SUB_BITS = 3;
+    static constexpr int SUB = 1 << SUB_BITS;
+    static constexpr int BUCKETS = 320; // covers up to ~2^40 ns
+
+    std::atomic<uint32_t> counts[BUCKETS] = {};
+    std::atomic<uint64_t> samples{ 0 };
+    std::atomic<uint64_t> sumNs{ 0 };
+    std::atomic<uint64_t> maxNs{ 0 };
+
+    static int bucketOf(uint64_t ns) {
+        if (ns < (uint64_t)SUB) return (int)ns;
+        int msb = 63;
+        while (!(ns >> msb)) --msb;
+        int shift = msb - SUB_BITS;
+        int b = (shift + 1) * SUB + (int)((ns >> shift) & (SUB - 1));
+        return std::min(b, BUCKETS - 1);
+    }
+
+    // [lower, lower + width) of bucket b
+    static uint64_t bucketLower(int b) {
+        if (b < SUB) return (uint64_t)b;
+        int shift = b / SUB - 1;
+        return (uint64_t)(SUB + b % SUB) << shift;
+    }
+    static uint64_t bucketWidth(int b) { return b < SUB ? 1 : (uint64_t)1 << (b / SUB - 1); }
+
+    void add(uint64_t ns) {
+        counts[bucketOf(ns)].fetch_add(1, std::memory_order_relaxed);
+        samples.fetch_add(1, std::memory_order_relaxed);
+        sumNs.fetch_add(ns, std::memory_order_relaxed);
+        uint64_t m = maxNs.load(std::memory_order_relaxed);
+        while (ns > m && !maxNs.compare_exchange_weak(m, ns, std::memory_order_relaxed)) {}
+    }
+
+    // q in [0, 1]; middle of the bucket holding that quantile, in ns
+    double percentile(double q) const {
+        uint64_t n = samples.load(std::memory_order_relaxed);
+        if (n == 0) return 0.0;
+        uint64_t rank = (uint64_t)(q * (double)n + 0.5);
+        rank = std::max<uint64_t>(1, std::min(rank, n));
+        uint64_t seen = 0;
+        for (int b = 0; b < BUCKETS; ++b) {
+            seen += counts[b].load(std::memory_order_relaxed);
+            if (seen >= rank)
+                return std::min((double)bucketLower(b) + (double)(bucketWidth(b) - 1) * 0.5,
+                    (double)maxNs.load(std::memory_order_relaxed));
+        }
+        return (double)maxNs.load(std::memory_order_relaxed);
+    }
+
+    double meanNs() const {
+        uint64_t n = samples.load(std::memory_order_relaxed);
+        return n ? (double)sumNs.load(std::memory_order_relaxed) / (double)n : 0.0;
+    }
+};
+
+struct TraceEvent {
+    uint64_t startNs;
+    uint32_t durNs;
+    uint16_t stage;
+};
+
+struct FrameProfiler {
+    static constexpr int MAX_STAGES = 32;
+
+    bool enabled = false;
+    bool tracing = false;
+    size_t maxTraceEvents = (size_t)1 << 20; // per thread
+
+    int stageCount = 0;
+    const char* stageNames[MAX_STAGES] = {};
+    StageHistogram histograms[MAX_STAGES];
+    uint64_t frameNs[MAX_STAGES] = {}; // this frame's total, owned by the stage's thread
+    bool ranThisFrame[MAX_STAGES] = {};
+    std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+    struct TraceBuffer {
+        int tid;
+        const char* name = nullptr;
+        std::vector<TraceEvent> events;
+        uint64_t dropped = 0;
+    };
+    std::mutex traceMutex; // guards traceBuffers (registration only)
+    std::vector<std::unique_ptr<TraceBuffer>> traceBuffers;
+
+    void setStages(const char* const* names, int count) {
+        stageCount = std::min(count, MAX_STAGES);
+        for (int i = 0; i < stageCount; ++i) stageNames[i] = names[i];
+    }
+
+    void enable(bool withTrace) {
+        enabled = true;
+        tracing = withTrace;
+    }
+
+    uint64_t now() const {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+    }
+
+    // the calling thread's trace buffer, registered on first use
+    TraceBuffer& threadTrace() {
+        static thread_local TraceBuffer* buffer = nullptr;
+        static thread_local const FrameProfiler* owner = nullptr;
+        if (!buffer || owner != this) {
+            std::lock_guard<std::mutex> lock(traceMutex);
+            traceBuffers.push_back(std::make_unique<TraceBuffer>());
+            buffer = traceBuffers.back().get();
+            buffer->tid = (int)traceBuffers.size();
+            owner = this;
+        }
+        return *buffer;
+    }
+
+    // label the calling thread in the trace
+    void nameThread(const char* name) {
+        if (tracing) threadTrace().name = name;
+    }
+
+    void record(int stage, uint64_t t0, uint64_t t1) {
+        frameNs[stage] += t1 - t0;
+        ranThisFrame[stage] = true;
+        if (!tracing) return;
+        TraceBuffer& tb = threadTrace();
+        if (tb.events.size() < maxTraceEvents) tb.events.push_back({ t0, (uint32_t)std::min<uint64_t>(t1 - t0, UINT32_MAX), (uint16_t)stage });
+        else ++tb.dropped;
+    }
+
+    // close the frame for stages [first, last]: each one that ran adds one sample
+    void endFrame(int first, int last) {
+        if (!enabled) return;
+        for (int s = first; s <= last; ++s) {
+            if (!ranThisFrame[s]) continue;
+            histograms[s].add(frameNs[s]);
+            frameNs[s] = 0;
+            ranThisFrame[s] = false;
+        }
+    }
+
+    // per-stage table in microseconds
+    void printReport(FILE* out) const {
+        fprintf(out, "%-20s %8s %9s %9s %9s %9s %9s\n", "stage", "frames", "mean_us", "p50_us", "p95_us", "p99_us", "max_us");
+        for (int s = 0; s < stageCount; ++s) {
+            const StageHistogram& h = histograms[s];
+            uint64_t n = h.samples.load(std::memory_order_relaxed);
+            if (n == 0) continue;
+            fprintf(out, "%-20s %8llu %9.1f %9.1f %9.1f %9.1f %9.1f\n", stageNames[s], (unsigned long long)n,
+                h.meanNs() / 1000.0, h.percentile(0.50) / 1000.0, h.percentile(0.95) / 1000.0,
+                h.percentile(0.99) / 1000.0, (double)h.maxNs.load(std::memory_order_relaxed) / 1000.0);
+        }
+    }
+
+    // Chrome trace-event JSON ("X" complete events, timestamps in microseconds); call once
+    // the timed threads have stopped. Returns false if the file cannot be written.
+    bool writeTrace(const char* path) {
+        FILE* f = fopen(path, "w");
+        if (!f) return false;
+        std::lock_guard<std::mutex> lock(traceMutex);
+        fprintf(f, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+        bool first = true;
+        uint64_t dropped = 0;
+        for (const auto& tb : traceBuffers) {
+            if (tb->name) {
+                fprintf(f, "%s{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, \"args\": {\"name\": \"%s\"}}",
+                    first ? "" : ",\n", tb->tid, tb->name);
+                first = false;
+            }
+            for (const TraceEvent& e : tb->events) {
+                fprintf(f, "%s{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f}",
+                    first ? "" : ",\n", stageNames[e.stage], tb->tid, e.startNs / 1000.0, e.durNs / 1000.0);
+                first = false;
+            }
+            dropped += tb->dropped;
+        }
+        fprintf(f, "\n], \"otherData\": {\"dropped_events\": %llu}}\n", (unsigned long long)dropped);
+        return fclose(f) == 0;
+    }
+};
+
+// Times the enclosing block as one occurrence of a stage
+class ProfileScope {
+public:
+    ProfileScope(FrameProfiler& p, int stage) : profiler(p), stage(stage), active(p.enabled) {
+        if (active) t0 = p.now();
+    }
+    ~ProfileScope() {
+        if (active) profiler.record(stage, t0, profiler.now());
+    }
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    FrameProfiler& profiler;
+    int stage;
+    bool active;
+    uint64_t t0 = 0;
+};
@@ -0,0 +1,1014 @@
+// raster.h
+// Header-only classic raster algorithms (DDA, Bresenham line, midpoint / Bresenham circle,
+// scanline-filled disc, span-filled thick line) shared by all the programs in this repo.
+//
+// Every kernel takes its pixel sink as a template parameter, so the per-pixel call is
+// resolved at compile time and inlines: no virtual dispatch, no function pointers.
+// A sink is any type with
+//     void plot(int x, int y);             // one pixel
+//     void span(int x0, int x1, int y);    // horizontal run [x0, x1] on row y
+//
+// GLPointSink is only defined when a GL header (GL/gl.h, GL/glut.h, GLFW/glfw3.h) has been
+// included before this file, so headless tools can use the library without linking GL.
+//
+// The *Clipped kernels take a clip rectangle and emit exactly the pixels of the unclipped
+// kernel that fall inside it, without generating the others (see "Clipping" below).
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstddef>
+#include <ostream>
+#include <type_traits>
+#include <vector>
+
+#include "framebuffer.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace raster {
+
+struct Point {
+    int x, y;
+    bool operator==(const Point& o) const { return x == o.x && y == o.y; }
+    bool operator!=(const Point& o) const { return !(*this == o); }
+};
+
+// ----- Pixel sinks -----
+
+// Writes pixels into a CPU framebuffer with a fixed color; spans are contiguous row fills
+struct FramebufferSink {
+    Framebuffer& fb;
+    uint32_t color;
+    void plot(int x, int y) { fb.setPixel(x, y, color); }
+    void span(int x0, int x1, int y) { fb.fillSpan(x0, x1, y, color); }
+};
+
+// Collects every emitted pixel, in emission order (spans are expanded left to right)
+struct PointCollector {
+    std::vector<Point> points;
+    void plot(int x, int y) { points.push_back({ x, y }); }
+    void span(int x0, int x1, int y) {
+        for (int x = x0; x <= x1; ++x) points.push_back({ x, y });
+    }
+};
+
+// Counts pixels and folds them into a checksum so benchmark loops cannot be optimized away
+struct CountingSink {
+    uint64_t pixels = 0;
+    uint64_t checksum = 0;
+    void plot(int x, int y) {
+        ++pixels;
+        checksum += (uint64_t)((int64_t)x * 31 + y);
+    }
+    void span(int x0, int x1, int y) {
+        if (x1 < x0) return;
+        int64_t n = (int64_t)x1 - x0 + 1;
+        pixels += (uint64_t)n;
+        // same value as plot() over every pixel of the run: 31 * sum(x) + n * y
+        checksum += (uint64_t)(((int64_t)x0 + x1) * n / 2 * 31 + n * y);
+    }
+};
+
+// Prints each pixel as "(x, y)" on its own line
+struct StreamSink {
+    std::ostream& os;
+    void plot(int x, int y) { os << "(" << x << ", " << y << ")\n"; }
+    void span(int x0, int x1, int y) {
+        for (int x = x0; x <= x1; ++x) plot(x, y);
+    }
+};
+
+#if defined(GL_VERSION_1_1)
+// Immediate-mode GL_POINTS; the caller brackets the kernel with glBegin(GL_POINTS)/glEnd()
+struct GLPointSink {
+    void plot(int x, int y) { glVertex2i(x, y); }
+    void span(int x0, int x1, int y) {
+        for (int x = x0; x <= x1; ++x) glVertex2i(x, y);
+    }
+};
+#endif
+
+// ----- Line algorithms -----
+
+// DDA line: float increments along the major axis, rounded per pixel
+template <class Sink>
+inline void lineDDA(Sink&& sink, int x0, int y0, int x1, int y1) {
+    int dx = x1 - x0;
+    int dy = y1 - y0;
+    int steps = std::abs(dx) > std::abs(dy) ? std::abs(dx) : std::abs(dy);
+    if (steps == 0) {
+        sink.plot(x0, y0);
+        return;
+    }
+    float Xinc = dx / (float)steps;
+    float Yinc = dy / (float)steps;
+    float x = (float)x0;
+    float y = (float)y0;
+    for (int i = 0; i <= steps; ++i) {
+        sink.plot((int)roundf(x), (int)roundf(y));
+        x += Xinc;
+        y += Yinc;
+    }
+}
+
+// DDA line that only plots every other run of dashLen pixels (dashed aim line)
+template <class Sink>
+inline void dashedLineDDA(Sink&& sink, int x0, int y0, int x1, int y1, int dashLen) {
+    int dx = x1 - x0, dy = y1 - y0;
+    int steps = std::abs(dx) > std::abs(dy) ? std::abs(dx) : std::abs(dy);
+    if (steps == 0) return;
+    float Xinc = dx / (float)steps;
+    float Yinc = dy / (float)steps;
+    float x = (float)x0, y = (float)y0;
+    bool drawSeg = true;
+    int cnt = 0;
+    for (int i = 0; i <= steps; i++) {
+        if (drawSeg) sink.plot((int)roundf(x), (int)roundf(y));
+        cnt++;
+        if (cnt >= dashLen) { drawSeg = !drawSeg; cnt = 0; }
+        x += Xinc; y += Yinc;
+    }
+}
+
+// Bresenham line, single error term over both axes (general, all octants)
+template <class Sink>
+inline void lineBresenham(Sink&& sink, int x0, int y0, int x1, int y1) {
+    int dx = std::abs(x1 - x0);
+    int dy = std::abs(y1 - y0);
+    int sx = (x0 < x1) ? 1 : -1;
+    int sy = (y0 < y1) ? 1 : -1;
+    int err = dx - dy;
+
+    while (true) {
+        sink.plot(x0, y0);
+        if (x0 == x1 && y0 == y1) break;
+        int e2 = 2 * err;
+        if (e2 > -dy) { err -= dy; x0 += sx; }
+        if (e2 < dx) { err += dx; y0 += sy; }
+    }
+}
+
+// Bresenham line, textbook form: step the major axis, decision variable p for the minor one
+template <class Sink>
+inline void lineBresenhamMajorAxis(Sink&& sink, int x0, int y0, int x1, int y1) {
+    int dx = x1 - x0;
+    int dy = y1 - y0;
+    int sx = dx >= 0 ? 1 : -1;
+    int sy = dy >= 0 ? 1 : -1;
+    if (dx < 0) dx = -dx;
+    if (dy < 0) dy = -dy;
+
+    int x = x0;
+    int y = y0;
+
+    if (dx > dy) {
+        int p = 2 * dy - dx;
+        for (int i = 0; i <= dx; i++) {
+            sink.plot(x, y);
+            x = x + sx;
+            if (p >= 0) {
+                y = y + sy;
+                p = p - 2 * dx;
+            }
+            p = p + 2 * dy;
+        }
+    }
+    else {
+        int p = 2 * dx - dy;
+        for (int i = 0; i <= dy; i++) {
+            sink.plot(x, y);
+            y = y + sy;
+            if (p >= 0) {
+                x = x + sx;
+                p = p - 2 * dy;
+            }
+            p = p + 2 * dx;
+        }
+    }
+}
+
+// Run-slice Bresenham: lineBresenham's pixels k = kLo .. kHi (k counts major-axis steps
+// from (x0, y0)), produced a run at a time. Pixel k is q(k) minor steps out (see
+// lineBresenhamClipped), so the run on minor step j starts at
+// k = ceil((dmajor * (2j - 1) + 1) / (2 * dminor)); consecutive starts are dmajor / dminor
+// or one more apart, and one remainder update per run says which. An x-major line's runs are
+// horizontal and go to the sink as spans; a y-major line's are vertical and are plotted
+// pixel by pixel, with no decision left inside the run.
+template <class Sink>
+inline void lineRunSliceRange(Sink&& sink, int x0, int y0, int x1, int y1, long long kLo, long long kHi) {
+    if (kLo > kHi) return;
+    const int dx = std::abs(x1 - x0), dy = std::abs(y1 - y0);
+    const int sx = (x0 < x1) ? 1 : -1;
+    const int sy = (y0 < y1) ? 1 : -1;
+    const bool xMajor = dx >= dy;
+    const int dMaj = xMajor ? dx : dy, dMin = xMajor ? dy : dx;
+    const int last = (int)kHi;
+    int j = 0, next = last + 1, rem = 0, D = 1, whole = 0, frac = 0;
+    if (dMin > 0) {
+        D = 2 * dMin;
+        j = (int)((2LL * dMin * kLo + dMaj - 1) / (2LL * dMaj));
+        // start of run j + 1 = (dMaj * (2j + 1) + D) / D, kept as quotient and remainder
+        const long long m = (long long)dMaj * (2LL * j + 1) + D;
+        next = (int)(m / D);
+        rem = (int)(m % D);
+        whole = dMaj / dMin; // 2 * dMaj / D
+        frac = 2 * (dMaj % dMin);
+    }
+    int k = (int)kLo;
+    if (xMajor) {
+        int x = x0 + sx * k, y = y0 + sy * j;
+        for (;;) {
+            const int end = next <= last ? next : last + 1; // one past the run
+            const int xEnd = x + sx * (end - 1 - k);
+            if (sx > 0) sink.span(x, xEnd, y);
+            else sink.span(xEnd, x, y);
+            if (end > last) break;
+            x = xEnd + sx;
+            y += sy;
+            k = end;
+            next += whole;
+            rem += frac;
+            if (rem >= D) { rem -= D; ++next; }
+        }
+    }
+    else {
+        int x = x0 + sx * j, y = y0 + sy * k;
+        for (;;) {
+            const int end = next <= last ? next : last + 1;
+            for (; k < end; ++k, y += sy) sink.plot(x, y);
+            if (end > last) break;
+            x += sx;
+            next += whole;
+            rem += frac;
+            if (rem >= D) { rem -= D; ++next; }
+        }
+    }
+}
+
+// Run-slice Bresenham over the whole line: exactly lineBresenham's pixels, one span per run
+// on shallow lines
+template <class Sink>
+inline void lineRunSlice(Sink&& sink, int x0, int y0, int x1, int y1) {
+    const int dx = std::abs(x1 - x0), dy = std::abs(y1 - y0);
+    lineRunSliceRange(sink, x0, y0, x1, y1, 0, dx > dy ? dx : dy);
+}
+
+// Whether lineRunSlice beats stepping pixel by pixel on a line with these extents: only for
+// horizontal runs (a vertical run is still plotted pixel by pixel) that average 3 pixels or
+// more, on lines long enough to repay the divisions that set it up (raster_bench)
+inline bool runSlicePays(int dx, int dy) {
+    dx = std::abs(dx);
+    dy = std::abs(dy);
+    return dx >= 8 && dx >= 3 * dy;
+}
+
+// ----- Octant-specialized Bresenham -----
+// lineBresenham tests both step directions on every pixel, and lineBresenhamMajorAxis carries
+// its major axis and step signs as runtime values. Here all three are template parameters,
+// picked once per line, and the loop body is an add, a compare and selects the compiler
+// turns into conditional moves; the loop counter is the only branch. (A mask-and-add body
+// measured slower: its dependency chain from one pixel's error term to the next is longer.)
+// Pixel k (k major-axis steps from the start) is
+// q(k) = floor((2 * dminor * k + dmajor - tie) / (2 * dmajor)) minor steps out, where
+// tie = 1 rounds halfway pixels toward the start (lineBresenham) and tie = 0 away from it
+// (lineBresenhamMajorAxis); e is that numerator's remainder minus 2 * dmajor, so the minor
+// axis steps when it reaches 0. A FramebufferSink whose clip rectangle holds the whole line
+// is written through a pointer with constant strides (+-1 along a row, +-width across rows).
+
+template <bool XMajor, int SX, int SY, class Sink>
+inline void bresenhamOctantPlot(Sink&& sink, int x, int y, int e, int count, int twoMin, int twoMaj) {
+    sink.plot(x, y);
+    for (int i = 1; i < count; ++i) {
+        const int en = e + twoMin;
+        const bool step = en >= 0; // the minor axis steps
+        e = step ? en - twoMaj : en;
+        if (XMajor) { x += SX; y += step ? SY : 0; }
+        else { y += SY; x += step ? SX : 0; }
+        sink.plot(x, y);
+    }
+}
+
+template <bool XMajor, int SX, int SY>
+inline void bresenhamOctantStore(uint32_t* p, ptrdiff_t width, uint32_t color, int e, int count, int twoMin, int twoMaj) {
+    const ptrdiff_t major = XMajor ? SX : SY * width;
+    const ptrdiff_t diagonal = major + (XMajor ? SY * width : SX);
+    *p = color;
+    for (int i = 1; i < count; ++i) {
+        const int en = e + twoMin;
+        const bool step = en >= 0;
+        e = step ? en - twoMaj : en;
+        p += step ? diagonal : major;
+        *p = color;
+    }
+}
+
+// Calls f(XMajor, SX, SY) with the three as std::integral_constant values
+template <class F>
+inline void dispatchOctant(bool xMajor, int sx, int sy, F&& f) {
+    using X = std::true_type;
+    using Y = std::false_type;
+    using P = std::integral_constant<int, 1>;
+    using N = std::integral_constant<int, -1>;
+    switch ((xMajor ? 4 : 0) | (sx > 0 ? 2 : 0) | (sy > 0 ? 1 : 0)) {
+    case 0: f(Y{}, N{}, N{}); break;
+    case 1: f(Y{}, N{}, P{}); break;
+    case 2: f(Y{}, P{}, N{}); break;
+    case 3: f(Y{}, P{}, P{}); break;
+    case 4: f(X{}, N{}, N{}); break;
+    case 5: f(X{}, N{}, P{}); break;
+    case 6: f(X{}, P{}, N{}); break;
+    default: f(X{}, P{}, P{}); break;
+    }
+}
+
+// Pixels k = kLo .. kHi of the line, in order, through the octant's specialized loop
+template <class Sink>
+inline void lineBresenhamOctantRange(Sink&& sink, int x0, int y0, int x1, int y1, long long kLo, long long kHi, int tie = 1) {
+    if (kLo > kHi) return;
+    const int dx = std::abs(x1 - x0), dy = std::abs(y1 - y0);
+    const int sx = (x0 < x1) ? 1 : -1;
+    const int sy = (y0 < y1) ? 1 : -1;
+    const bool xMajor = dx >= dy;
+    const long long dMaj = xMajor ? dx : dy, dMin = xMajor ? dy : dx;
+    if (dMaj == 0) {
+        sink.plot(x0, y0);
+        return;
+    }
+    // from the start no division is needed: q(0) = 0 and the remainder is dMaj - tie
+    const long long num = 2 * dMin * kLo + dMaj - tie;
+    const int q = kLo == 0 ? 0 : (int)(num / (2 * dMaj));
+    const int e = (int)((kLo == 0 ? num : num % (2 * dMaj)) - 2 * dMaj);
+    const int x = x0 + sx * (int)(xMajor ? kLo : q);
+    const int y = y0 + sy * (int)(xMajor ? q : kLo);
+    const int count = (int)(kHi - kLo + 1);
+    const int twoMin = (int)(2 * dMin), twoMaj = (int)(2 * dMaj);
+    if constexpr (std::is_same<typename std::decay<Sink>::type, FramebufferSink>::value) {
+        const Framebuffer& fb = sink.fb;
+        const int qEnd = kHi == dMaj ? (int)dMin : (int)((2 * dMin * kHi + dMaj - tie) / (2 * dMaj));
+        const int xe = x0 + sx * (int)(xMajor ? kHi : qEnd);
+        const int ye = y0 + sy * (int)(xMajor ? qEnd : kHi);
+        if (fb.insideClip(x, y) && fb.insideClip(xe, ye)) {
+            dispatchOctant(xMajor, sx, sy, [&](auto xm, auto sxc, auto syc) {
+                bresenhamOctantStore<decltype(xm)::value, decltype(sxc)::value, decltype(syc)::value>(
+                    sink.fb.row(y) + x, sink.fb.width, sink.color, e, count, twoMin, twoMaj);
+            });
+            return;
+        }
+    }
+    dispatchOctant(xMajor, sx, sy, [&](auto xm, auto sxc, auto syc) {
+        bresenhamOctantPlot<decltype(xm)::value, decltype(sxc)::value, decltype(syc)::value>(sink, x, y, e, count, twoMin, twoMaj);
+    });
+}
+
+// Exactly lineBresenham's pixels, in the same order
+template <class Sink>
+inline void lineBresenhamOctant(Sink&& sink, int x0, int y0, int x1, int y1) {
+    const int dx = std::abs(x1 - x0), dy = std::abs(y1 - y0);
+    lineBresenhamOctantRange(sink, x0, y0, x1, y1, 0, dx > dy ? dx : dy, 1);
+}
+
+// Exactly lineBresenhamMajorAxis's pixels, in the same order
+template <class Sink>
+inline void lineBresenhamMajorAxisOctant(Sink&& sink, int x0, int y0, int x1, int y1) {
+    const int dx = std::abs(x1 - x0), dy = std::abs(y1 - y0);
+    lineBresenhamOctantRange(sink, x0, y0, x1, y1, 0, dx > dy ? dx : dy, 0);
+}
+
+// ----- Fixed-point DDA -----
+// lineDDA steps float coordinates and rounds each one with roundf: a libm call per
+// coordinate, and the float sums drift off the exact line as it gets longer and farther
+// from the origin. DDAFixed keeps each coordinate in 32.32 fixed point in an int64,
+// starting half a pixel in and stepping by the increment rounded up, so a pixel is the
+// integer part (a shift) and the rounding rule is exact: pixel k of a line of
+// n = max(|dx|, |dy|) steps is
+//     (floor(x0 + dx * k / n + 1/2), floor(y0 + dy * k / n + 1/2))
+// the exact position rounded half up (toward +infinity; roundf rounds halves away from
+// zero). Rounding the increment up adds under k / 2^32 of a pixel by step k, and a position
+// that is not a half is at least 1 / (2n) below the next rounding boundary, so the rule
+// holds for every line of up to DDA_FIXED_EXACT_STEPS steps. Past that a pixel just below a
+// half can come out one too far. Any pixel's position is also available directly
+// (xAt / yAt), so clipping and dashing can skip ahead without stepping.
+// Coordinate differences must fit in an int and lines be shorter than 2^30 steps.
+
+constexpr int DDA_FIXED_EXACT_STEPS = 46340; // largest n with n * n < 2^31
+
+struct DDAFixed {
+    static constexpr int64_t ONE = int64_t(1) << 32;
+    long long steps = 0;
+    int64_t x = 0, y = 0;       // pixel 0 plus one half, 32.32
+    int64_t xInc = 0, yInc = 0; // per step, rounded up
+
+    DDAFixed(int x0, int y0, int x1, int y1) {
+        const int64_t dx = (int64_t)x1 - x0, dy = (int64_t)y1 - y0;
+        const int64_t adx = dx < 0 ? -dx : dx, ady = dy < 0 ? -dy : dy;
+        steps = adx > ady ? adx : ady;
+        x = x0 * ONE + ONE / 2;
+        y = y0 * ONE + ONE / 2;
+        if (steps > 0) {
+            xInc = increment(dx);
+            yInc = increment(dy);
+        }
+    }
+
+    int xAt(long long k) const { return (int)((x + k * xInc) >> 32); }
+    int yAt(long long k) const { return (int)((y + k * yInc) >> 32); }
+
+private:
+    // d * 2^32 / steps, rounded up
+    int64_t increment(int64_t d) const { return d >= 0 ? (d * ONE + steps - 1) / steps : -((-d * ONE) / steps); }
+};
+
+// Pixels k = kLo .. kHi of a fixed-point DDA line
+template <class Sink>
+inline void ddaFixedRun(Sink&& sink, const DDAFixed& l, long long kLo, long long kHi) {
+    int64_t x = l.x + kLo * l.xInc, y = l.y + kLo * l.yInc;
+    for (long long k = kLo; k <= kHi; ++k) {
+        sink.plot((int)(x >> 32), (int)(y >> 32));
+        x += l.xInc;
+        y += l.yInc;
+    }
+}
+
+// Pixels k = kLo .. kHi that fall in a dash: dashLen pixels on, dashLen off, from k = 0
+// (dashedLineDDA's pattern). Gaps are skipped, not stepped through.
+template <class Sink>
+inline void ddaFixedDashedRun(Sink&& sink, const DDAFixed& l, long long kLo, long long kHi, int dashLen) {
+    if (dashLen < 1) dashLen = 1;
+    for (long long k = kLo; k <= kHi;) {
+        const long long dash = k / dashLen;
+        const long long end = (dash + 1) * dashLen - 1 < kHi ? (dash + 1) * dashLen - 1 : kHi;
+        if (dash % 2 == 0) ddaFixedRun(sink, l, k, end);
+        k = end + 1;
+    }
+}
+
+// Fixed-point DDA line (rounding rule above)
+template <class Sink>
+inline void lineDDAFixed(Sink&& sink, int x0, int y0, int x1, int y1) {
+    const DDAFixed l(x0, y0, x1, y1);
+    ddaFixedRun(sink, l, 0, l.steps);
+}
+
+// Fixed-point dashed DDA line: the pattern and pixel count of dashedLineDDA
+template <class Sink>
+inline void dashedLineDDAFixed(Sink&& sink, int x0, int y0, int x1, int y1, int dashLen) {
+    const DDAFixed l(x0, y0, x1, y1);
+    if (l.steps > 0) ddaFixedDashedRun(sink, l, 0, l.steps, dashLen);
+}
+
+// Fixed-point DDA line computing 8 pixel coordinates per step, with AVX2 when built with
+// -mavx2 or -march=native (8 lanes of plain integer code otherwise); same pixels, same order
+template <class Sink>
+inline void lineDDAFixed8(Sink&& sink, int x0, int y0, int x1, int y1) {
+    const DDAFixed l(x0, y0, x1, y1);
+    const long long n = l.steps + 1;
+    alignas(32) int xs[8], ys[8];
+    long long k = 0;
+#if defined(__AVX2__)
+    // even pixels of the block in one register and odd ones in the other: their integer
+    // parts (high halves) then interleave into pixel order with one blend
+    const __m256i xStep = _mm256_set1_epi64x(8 * l.xInc), yStep = _mm256_set1_epi64x(8 * l.yInc);
+    __m256i xe = _mm256_setr_epi64x(l.x, l.x + 2 * l.xInc, l.x + 4 * l.xInc, l.x + 6 * l.xInc);
+    __m256i ye = _mm256_setr_epi64x(l.y, l.y + 2 * l.yInc, l.y + 4 * l.yInc, l.y + 6 * l.yInc);
+    __m256i xo = _mm256_add_epi64(xe, _mm256_set1_epi64x(l.xInc));
+    __m256i yo = _mm256_add_epi64(ye, _mm256_set1_epi64x(l.yInc));
+    for (; k + 8 <= n; k += 8) {
+        _mm256_store_si256((__m256i*)xs, _mm256_blend_epi32(_mm256_srli_epi64(xe, 32), xo, 0xAA));
+        _mm256_store_si256((__m256i*)ys, _mm256_blend_epi32(_mm256_srli_epi64(ye, 32), yo, 0xAA));
+        for (int i = 0; i < 8; ++i) sink.plot(xs[i], ys[i]);
+        xe = _mm256_add_epi64(xe, xStep);
+        xo = _mm256_add_epi64(xo, xStep);
+        ye = _mm256_add_epi64(ye, yStep);
+        yo = _mm256_add_epi64(yo, yStep);
+    }
+#else
+    int64_t lx[8], ly[8];
+    for (int i = 0; i < 8; ++i) {
+        lx[i] = l.x + i * l.xInc;
+        ly[i] = l.y + i * l.yInc;
+    }
+    for (; k + 8 <= n; k += 8) {
+        for (int i = 0; i < 8; ++i) {
+            xs[i] = (int)(lx[i] >> 32);
+            ys[i] = (int)(ly[i] >> 32);
+            lx[i] += 8 * l.xInc;
+            ly[i] += 8 * l.yInc;
+        }
+        for (int i = 0; i < 8; ++i) sink.plot(xs[i], ys[i]);
+    }
+#endif
+    ddaFixedRun(sink, l, k, l.steps);
+}
+
+// name of the variant compiled into lineDDAFixed8
+inline const char* ddaKernelName() {
+#if defined(__AVX2__)
+    return "avx2";
+#else
+    return "scalar";
+#endif
+}
+
+// ----- Circle algorithms -----
+
+// Plot the eight symmetric points of (x, y) around (xc, yc)
+template <class Sink>
+inline void plotCirclePoints(Sink&& sink, int xc, int yc, int x, int y) {
+    sink.plot(xc + x, yc + y);
+    sink.plot(xc - x, yc + y);
+    sink.plot(xc + x, yc - y);
+    sink.plot(xc - x, yc - y);
+    sink.plot(xc + y, yc + x);
+    sink.plot(xc - y, yc + x);
+    sink.plot(xc + y, yc - x);
+    sink.plot(xc - y, yc - x);
+}
+
+// Midpoint circle outline (d = 1 - r)
+template <class Sink>
+inline void circleMidpoint(Sink&& sink, int xc, int yc, int r) {
+    if (r < 0) return;
+    int x = 0;
+    int y = r;
+    int d = 1 - r;
+
+    while (x <= y) {
+        plotCirclePoints(sink, xc, yc, x, y);
+        if (d < 0) {
+            d += 2 * x + 3;
+        }
+        else {
+            d += 2 * (x - y) + 5;
+            y--;
+        }
+        x++;
+    }
+}
+
+// Bresenham circle outline (d = 3 - 2r)
+template <class Sink>
+inline void circleBresenham(Sink&& sink, int xc, int yc, int r) {
+    int x = 0, y = r;
+    int d = 3 - 2 * r;
+
+    while (x <= y) {
+        plotCirclePoints(sink, xc, yc, x, y);
+        if (d < 0)
+            d += 4 * x + 6;
+        else {
+            d += 4 * (x - y) + 10;
+            y--;
+        }
+        x++;
+    }
+}
+
+// Filled disc with one span per scanline, using the same midpoint decision variable as
+// circleMidpoint so the disc covers exactly the pixels inside its outline.
+// Row yc +- x (x advancing every step) spans [-y, y]; row yc +- y is emitted once, right
+// before y steps down, when x has reached its widest value on that row.
+template <class Sink>
+inline void fillCircleMidpoint(Sink&& sink, int xc, int yc, int r) {
+    if (r < 0) return;
+    int x = 0;
+    int y = r;
+    int d = 1 - r;
+
+    while (x <= y) {
+        sink.span(xc - y, xc + y, yc + x);
+        if (x != 0) sink.span(xc - y, xc + y, yc - x);
+
+        if (d < 0) {
+            d += 2 * x + 3;
+        }
+        else {
+            // last pixel on rows yc +- y; rows with y == x were already covered above
+            if (y != x) {
+                sink.span(xc - x, xc + x, yc + y);
+                sink.span(xc - x, xc + x, yc - y);
+            }
+            d += 2 * (x - y) + 5;
+            y--;
+        }
+        x++;
+    }
+}
+
+// ----- Rectangles -----
+
+// Filled axis-aligned rectangle [x0, x1] x [y0, y1], one span per row
+template <class Sink>
+inline void fillRect(Sink&& sink, int x0, int y0, int x1, int y1) {
+    for (int y = y0; y <= y1; ++y) sink.span(x0, x1, y);
+}
+
+// ----- Thick lines -----
+// A line of any width is a convex shape: the segment widened by width / 2 on both sides
+// (a quad), optionally extended by width / 2 past each end (Square) or rounded there with
+// a half disc (Round, a capsule). A convex shape crosses each row in one interval, so the
+// line is drawn as one span per row and every pixel is written exactly once, however steep
+// or wide it is. A pixel is covered when its center (x, y) lies inside the shape, counting
+// the edges at smaller x and y but not those at larger x and y, so two lines sharing an edge
+// never both draw it and a width-w axis-aligned line is exactly w pixels wide.
+
+enum class LineCap { Butt, Square, Round };
+
+// Calls emit(x0, x1, y) for each row of the thick line, in increasing y (bottom-up in the
+// framebuffer, whose row 0 is the bottom of the screen)
+template <class Emit>
+inline void thickLineSpans(int x0, int y0, int x1, int y1, float width, LineCap cap, Emit&& emit) {
+    if (!(width > 0.0f)) return;
+    const double R = 0.5 * width;
+    const double dx = x1 - x0, dy = y1 - y0;
+    const double len = std::sqrt(dx * dx + dy * dy);
+    // a zero-length line has no direction; give it the horizontal one
+    const double ux = len > 0.0 ? dx / len : 1.0, uy = len > 0.0 ? dy / len : 0.0;
+    double ax = x0, ay = y0, bx = x1, by = y1;
+    if (cap == LineCap::Square) {
+        ax -= ux * R; ay -= uy * R;
+        bx += ux * R; by += uy * R;
+    }
+    const double nx = -uy * R, ny = ux * R;
+    const double qx[4] = { ax + nx, bx + nx, bx - nx, ax - nx };
+    const double qy[4] = { ay + ny, by + ny, by - ny, ay - ny };
+
+    double yMin = qy[0], yMax = qy[0];
+    for (int i = 1; i < 4; ++i) {
+        yMin = qy[i] < yMin ? qy[i] : yMin;
+        yMax = qy[i] > yMax ? qy[i] : yMax;
+    }
+    if (cap == LineCap::Round) {
+        yMin = std::fmin(yMin, (y0 < y1 ? y0 : y1) - R);
+        yMax = std::fmax(yMax, (y0 > y1 ? y0 : y1) + R);
+    }
+
+    const int rowEnd = (int)std::ceil(yMax);
+    for (int y = (int)std::ceil(yMin); y < rowEnd; ++y) {
+        double left = HUGE_VAL, right = -HUGE_VAL;
+        for (int i = 0; i < 4; ++i) {
+            const int j = (i + 1) & 3;
+            const double ya = qy[i], yb = qy[j];
+            if ((y < ya && y < yb) || (y > ya && y > yb)) continue;
+            if (ya == yb) { // horizontal edge on this row
+                left = std::fmin(left, std::fmin(qx[i], qx[j]));
+                right = std::fmax(right, std::fmax(qx[i], qx[j]));
+                continue;
+            }
+            const double x = qx[i] + (y - ya) * (qx[j] - qx[i]) / (yb - ya);
+            left = std::fmin(left, x);
+            right = std::fmax(right, x);
+        }
+        if (cap == LineCap::Round) {
+            const int ex[2] = { x0, x1 }, ey[2] = { y0, y1 };
+            for (int e = 0; e < 2; ++e) {
+                const double d = y - ey[e];
+                if (d * d > R * R) continue;
+                const double h = std::sqrt(R * R - d * d);
+                left = std::fmin(left, ex[e] - h);
+                right = std::fmax(right, ex[e] + h);
+            }
+        }
+        if (left > right) continue;
+        const int xa = (int)std::ceil(left), xb = (int)std::ceil(right) - 1;
+        if (xa <= xb) emit(xa, xb, y);
+    }
+}
+
+// Thick line from (x0, y0) to (x1, y1), width pixels across
+template <class Sink>
+inline void thickLine(Sink&& sink, int x0, int y0, int x1, int y1, float width, LineCap cap = LineCap::Butt) {
+    thickLineSpans(x0, y0, x1, y1, width, cap, [&](int a, int b, int y) { sink.span(a, b, y); });
+}
+
+// ----- Clipping -----
+// Primitives whose bounding box lies inside the clip rectangle go straight to the unclipped
+// kernel; those wholly outside it are rejected without touching a pixel. Only the rest pay
+// for clipping, and none of them changes which on-screen pixels are drawn.
+
+// Inclusive clip rectangle [x0, x1] x [y0, y1]
+struct ClipRect {
+    int x0, y0, x1, y1;
+    bool contains(int x, int y) const { return x >= x0 && x <= x1 && y >= y0 && y <= y1; }
+};
+
+// What the clipped kernels left out; accumulates across calls
+struct ClipStats {
+    uint64_t clippedPixels = 0; // pixels the unclipped kernel would have emitted outside the rect
+    uint64_t rejected = 0;      // primitives with no pixel inside the rect
+};
+
+// Cohen-Sutherland outcode of (x, y) against c
+enum { CLIP_LEFT = 1, CLIP_RIGHT = 2, CLIP_BELOW = 4, CLIP_ABOVE = 8 };
+inline int outcode(const ClipRect& c, int x, int y) {
+    return (x < c.x0 ? CLIP_LEFT : 0) | (x > c.x1 ? CLIP_RIGHT : 0) | (y < c.y0 ? CLIP_BELOW : 0) | (y > c.y1 ? CLIP_ABOVE : 0);
+}
+
+// Bresenham line clipped to c. Pixel k of the line (k = 0 .. max(dx, dy)) lies k steps
+// along the major axis and q(k) = floor((2 * dminor * k + dmajor - 1) / (2 * dmajor))
+// steps along the minor one, which is where lineBresenham's error term puts it. Both are
+// monotone in k, so the visible pixels are one interval [kLo, kHi], found Liang-Barsky
+// style from the four edges, and that interval alone is drawn: as runs on shallow lines
+// (lineRunSliceRange), otherwise by the octant-specialized loop started at kLo.
+template <class Sink>
+inline void lineBresenhamClipped(Sink&& sink, const ClipRect& c, ClipStats& stats, int x0, int y0, int x1, int y1) {
+    int oc0 = outcode(c, x0, y0), oc1 = outcode(c, x1, y1);
+    if (!(oc0 | oc1)) {
+        if (runSlicePays(x1 - x0, y1 - y0)) lineRunSlice(sink, x0, y0, x1, y1);
+        else lineBresenhamOctant(sink, x0, y0, x1, y1);
+        return;
+    }
+    int dx = std::abs(x1 - x0);
+    int dy = std::abs(y1 - y0);
+    int sx = (x0 < x1) ? 1 : -1;
+    int sy = (y0 < y1) ? 1 : -1;
+    long long n = dx > dy ? dx : dy; // last pixel index
+    if (oc0 & oc1) {
+        ++stats.rejected;
+        stats.clippedPixels += (uint64_t)n + 1;
+        return;
+    }
+
+    bool xMajor = dx >= dy;
+    long long dMaj = xMajor ? dx : dy, dMin = xMajor ? dy : dx;
+    // steps of the line along each axis that stay inside c
+    auto stepRange = [](int from, int dir, int lo, int hi, long long& sLo, long long& sHi) {
+        sLo = dir > 0 ? (long long)lo - from : (long long)from - hi;
+        sHi = dir > 0 ? (long long)hi - from : (long long)from - lo;
+    };
+    long long majLo, majHi, minLo, minHi;
+    if (xMajor) {
+        stepRange(x0, sx, c.x0, c.x1, majLo, majHi);
+        stepRange(y0, sy, c.y0, c.y1, minLo, minHi);
+    }
+    else {
+        stepRange(y0, sy, c.y0, c.y1, majLo, majHi);
+        stepRange(x0, sx, c.x0, c.x1, minLo, minHi);
+    }
+    long long kLo = majLo > 0 ? majLo : 0;
+    long long kHi = majHi < n ? majHi : n;
+    // q(k) >= minLo  <=>  k >= (dMaj * (2 * minLo - 1) + 1) / (2 * dMin), rounded up
+    // q(k) <= minHi  <=>  k <= dMaj * (2 * minHi + 1) / (2 * dMin), rounded down
+    if (dMin == 0) {
+        if (minLo > 0 || minHi < 0) kHi = -1;
+    }
+    else {
+        if (minLo > 0) {
+            long long k = (dMaj * (2 * minLo - 1) + 1 + 2 * dMin - 1) / (2 * dMin);
+            if (k > kLo) kLo = k;
+        }
+        if (minHi < 0) kHi = -1;
+        else {
+            long long k = dMaj * (2 * minHi + 1) / (2 * dMin);
+            if (k < kHi) kHi = k;
+        }
+    }
+    if (kLo > kHi) {
+        ++stats.rejected;
+        stats.clippedPixels += (uint64_t)n + 1;
+        return;
+    }
+    stats.clippedPixels += (uint64_t)(n - (kHi - kLo));
+    if (runSlicePays(dx, dy)) lineRunSliceRange(sink, x0, y0, x1, y1, kLo, kHi);
+    else lineBresenhamOctantRange(sink, x0, y0, x1, y1, kLo, kHi);
+}
+
+inline long long floorDiv(long long a, long long b) { // b > 0
+    return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+inline long long ceilDiv(long long a, long long b) { return -floorDiv(-a, b); } // b > 0
+
+// Narrow [kLo, kHi] to the steps k whose coordinate (start + k * inc) >> 32 lies in [lo, hi]
+inline void ddaFixedAxisRange(int64_t start, int64_t inc, long long steps, int lo, int hi, long long& kLo, long long& kHi) {
+    // that is a <= k * inc <= b; bounds farther away than the line travels are clamped
+    // first so the products cannot overflow
+    const int64_t ONE = DDAFixed::ONE;
+    const int from = (int)(start >> 32);
+    const int64_t frac = start - from * ONE;
+    auto offset = [steps](long long d) { return d < -(steps + 2) ? -(steps + 2) : d > steps + 2 ? steps + 2 : d; };
+    const int64_t a = offset((long long)lo - from) * ONE - frac;
+    const int64_t b = offset((long long)hi - from + 1) * ONE - 1 - frac;
+    long long first = kLo, last = kHi;
+    if (inc > 0) {
+        first = ceilDiv(a, inc);
+        last = floorDiv(b, inc);
+    }
+    else if (inc < 0) {
+        first = ceilDiv(-b, -inc);
+        last = floorDiv(-a, -inc);
+    }
+    else if (a > 0 || b < 0) last = kLo - 1;
+    if (first > kLo) kLo = first;
+    if (last < kHi) kHi = last;
+}
+
+// Pixels of l inside c: both coordinates are monotone in k, so they are the interval
+// [kLo, kHi] (empty when kLo > kHi), found directly from each axis' bounds
+inline void ddaFixedVisibleRange(const DDAFixed& l, const ClipRect& c, long long& kLo, long long& kHi) {
+    kLo = 0;
+    kHi = l.steps;
+    ddaFixedAxisRange(l.x, l.xInc, l.steps, c.x0, c.x1, kLo, kHi);
+    ddaFixedAxisRange(l.y, l.yInc, l.steps, c.y0, c.y1, kLo, kHi);
+}
+
+// lineDDAFixed clipped to c; starts at the first visible pixel instead of stepping to it
+template <class Sink>
+inline void lineDDAFixedClipped(Sink&& sink, const ClipRect& c, ClipStats& stats, int x0, int y0, int x1, int y1) {
+    const DDAFixed l(x0, y0, x1, y1);
+    long long kLo, kHi;
+    ddaFixedVisibleRange(l, c, kLo, kHi);
+    if (kLo > kHi) {
+        ++stats.rejected;
+        stats.clippedPixels += (uint64_t)l.steps + 1;
+        return;
+    }
+    stats.clippedPixels += (uint64_t)(l.steps - (kHi - kLo));
+    ddaFixedRun(sink, l, kLo, kHi);
+}
+
+// dashedLineDDAFixed clipped to c (the dash pattern keeps its phase). Pixels in the gaps
+// are not counted as clipped.
+template <class Sink>
+inline void dashedLineDDAFixedClipped(Sink&& sink, const ClipRect& c, ClipStats& stats, int x0, int y0, int x1, int y1, int dashLen) {
+    const DDAFixed l(x0, y0, x1, y1);
+    if (l.steps == 0) return;
+    const long long period = 2LL * (dashLen < 1 ? 1 : dashLen);
+    // dash pixels among k = 0 .. count - 1
+    auto dashPixels = [period](long long count) {
+        const long long rest = count % period;
+        return count / period * (period / 2) + (rest < period / 2 ? rest : period / 2);
+    };
+    long long kLo, kHi;
+    ddaFixedVisibleRange(l, c, kLo, kHi);
+    const long long total = dashPixels(l.steps + 1);
+    const long long visible = kLo > kHi ? 0 : dashPixels(kHi + 1) - dashPixels(kLo);
+    if (visible == 0) { // no pixel inside c, or only gaps
+        ++stats.rejected;
+        stats.clippedPixels += (uint64_t)total;
+        return;
+    }
+    stats.clippedPixels += (uint64_t)(total - visible);
+    ddaFixedDashedRun(sink, l, kLo, kHi, dashLen);
+}
+
+// Pixels circleMidpoint emits for radius r (8 per step, duplicates included)
+inline uint64_t circleMidpointPixels(int r) {
+    if (r < 0) return 0;
+    uint64_t n = 0;
+    int x = 0, y = r, d = 1 - r;
+    while (x <= y) {
+        n += 8;
+        if (d < 0) d += 2 * x + 3;
+        else { d += 2 * (x - y) + 5; y--; }
+        x++;
+    }
+    return n;
+}
+
+// Pixels fillCircleMidpoint covers for radius r
+inline uint64_t fillCircleMidpointPixels(int r) {
+    CountingSink counter;
+    fillCircleMidpoint(counter, 0, 0, r);
+    return counter.pixels;
+}
+
+// circleMidpoint clipped to c: bounding box accept/reject, otherwise each of the eight
+// symmetric points is tested on its own (and the circle still counts as rejected if none
+// of them is inside, e.g. c lies within the ring)
+template <class Sink>
+inline void circleMidpointClipped(Sink&& sink, const ClipRect& c, ClipStats& stats, int xc, int yc, int r) {
+    if (r < 0) return;
+    if (xc - r >= c.x0 && xc + r <= c.x1 && yc - r >= c.y0 && yc + r <= c.y1) {
+        circleMidpoint(sink, xc, yc, r);
+        return;
+    }
+    if (xc + r < c.x0 || xc - r > c.x1 || yc + r < c.y0 || yc - r > c.y1) {
+        ++stats.rejected;
+        stats.clippedPixels += circleMidpointPixels(r);
+        return;
+    }
+    uint64_t clipped = 0;
+    bool any = false;
+    auto plot = [&](int px, int py) {
+        if (c.contains(px, py)) { sink.plot(px, py); any = true; }
+        else ++clipped;
+    };
+    int x = 0;
+    int y = r;
+    int d = 1 - r;
+    while (x <= y) {
+        plot(xc + x, yc + y);
+        plot(xc - x, yc + y);
+        plot(xc + x, yc - y);
+        plot(xc - x, yc - y);
+        plot(xc + y, yc + x);
+        plot(xc - y, yc + x);
+        plot(xc + y, yc - x);
+        plot(xc - y, yc - x);
+        if (d < 0) {
+            d += 2 * x + 3;
+        }
+        else {
+            d += 2 * (x - y) + 5;
+            y--;
+        }
+        x++;
+    }
+    stats.clippedPixels += clipped;
+    if (!any) ++stats.rejected; // the box overlaps c but no pixel does
+}
+
+// fillCircleMidpoint clipped to c: bounding box accept/reject, otherwise every span is
+// cut to c (rows outside c are dropped whole; a disc with no span left counts as rejected)
+template <class Sink>
+inline void fillCircleMidpointClipped(Sink&& sink, const ClipRect& c, ClipStats& stats, int xc, int yc, int r) {
+    if (r < 0) return;
+    if (xc - r >= c.x0 && xc + r <= c.x1 && yc - r >= c.y0 && yc + r <= c.y1) {
+        fillCircleMidpoint(sink, xc, yc, r);
+        return;
+    }
+    if (xc + r < c.x0 || xc - r > c.x1 || yc + r < c.y0 || yc - r > c.y1) {
+        ++stats.rejected;
+        stats.clippedPixels += fillCircleMidpointPixels(r);
+        return;
+    }
+    uint64_t clipped = 0;
+    bool any = false;
+    auto span = [&](int sx0, int sx1, int sy) {
+        int w = sx1 - sx0 + 1;
+        if (sy < c.y0 || sy > c.y1) { clipped += (uint64_t)w; return; }
+        int a = sx0 > c.x0 ? sx0 : c.x0;
+        int b = sx1 < c.x1 ? sx1 : c.x1;
+        if (a <= b) {
+            sink.span(a, b, sy);
+            w -= b - a + 1;
+            any = true;
+        }
+        clipped += (uint64_t)w;
+    };
+    int x = 0;
+    int y = r;
+    int d = 1 - r;
+    while (x <= y) {
+        span(xc - y, xc + y, yc + x);
+        if (x != 0) span(xc - y, xc + y, yc - x);
+        if (d < 0) {
+            d += 2 * x + 3;
+        }
+        else {
+            if (y != x) {
+                span(xc - x, xc + x, yc + y);
+                span(xc - x, xc + x, yc - y);
+            }
+            d += 2 * (x - y) + 5;
+            y--;
+        }
+        x++;
+    }
+    stats.clippedPixels += clipped;
+    if (!any) ++stats.rejected; // the box overlaps c but no pixel does
+}
+
+// fillRect clipped to c
+template <class Sink>
+inline void fillRectClipped(Sink&& sink, const ClipRect& c, ClipStats& stats, int x0, int y0, int x1, int y1) {
+    if (x1 < x0 || y1 < y0) return;
+    int a = x0 > c.x0 ? x0 : c.x0, b = x1 < c.x1 ? x1 : c.x1;
+    int top = y0 > c.y0 ? y0 : c.y0, bottom = y1 < c.y1 ? y1 : c.y1;
+    uint64_t total = (uint64_t)(x1 - x0 + 1) * (uint64_t)(y1 - y0 + 1);
+    if (a > b || top > bottom) {
+        ++stats.rejected;
+        stats.clippedPixels += total;
+        return;
+    }
+    stats.clippedPixels += total - (uint64_t)(b - a + 1) * (uint64_t)(bottom - top + 1);
+    fillRect(sink, a, top, b, bottom);
+}
+
+// thickLine clipped to c. Computing a row's span costs a few multiplies, far less than
+// filling it, so every row is still computed (that also gives the exact clipped count)
+// and only the part inside c is filled.
+template <class Sink>
+inline void thickLineClipped(Sink&& sink, const ClipRect& c, ClipStats& stats, int x0, int y0, int x1, int y1,
+    float width, LineCap cap = LineCap::Butt) {
+    uint64_t clipped = 0;
+    bool any = false;
+    thickLineSpans(x0, y0, x1, y1, width, cap, [&](int a, int b, int y) {
+        const int span = b - a + 1;
+        if (y < c.y0 || y > c.y1) { clipped += span; return; }
+        a = a > c.x0 ? a : c.x0;
+        b = b < c.x1 ? b : c.x1;
+        if (a > b) { clipped += span; return; }
+        clipped += span - (b - a + 1);
+        any = true;
+        sink.span(a, b, y);
+    });
+    if (!any && clipped) ++stats.rejected;
+    stats.clippedPixels += clipped;
+}
+
+} // namespace raster
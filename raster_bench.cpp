@@ -0,0 +1,670 @@
+// raster_bench.cpp
+// Headless micro-benchmarks for the raster.h line and circle kernels (no window, no GL).
+// Build: g++ -O2 -std=c++17 raster_bench.cpp -o raster_bench
+// Run:   raster_bench [--sink counting|framebuffer] [--min-time ms] [--out results.json]
+//        raster_bench --check
+//
+// Lines are swept over short and long lengths in all eight octants, and again within 6
+// degrees of the axes ("axis_line": grid and aim lines, where runs are long), circles over
+// radii 1..512. For every case the report has ns per primitive, pixels per second, and the
+// pixel count and checksum of the output, so a behaviour change shows up next to a speed
+// change when two commits are compared.
+//
+// The "accuracy" section compares the DDA kernels with the exact line and with
+// lineBresenham on lines up to 40000 px: how far a pixel lies from the exact position (0.5
+// at most for a correctly rounded line), how many pixels are not the nearest one, and how
+// many differ from Bresenham's (which rounds halves toward the start).
+//
+// --check runs the correctness checks instead of the benchmarks, prints one line per check
+// and exits with status 1 if any of them found a mismatch:
+//   octant  lineBresenhamOctant / lineBresenhamMajorAxisOctant against lineBresenham /
+//           lineBresenhamMajorAxis, point for point, for every pair of endpoints in
+//           [-16, 16]^2; and the same lines drawn through a FramebufferSink (whose direct
+//           store path is taken when the clip rectangle holds the whole line) against
+//           setPixel of the reference points, under a clip rectangle that cuts many of them
+//   runslice  lineRunSlice against lineBresenham for every pair of endpoints in [-14, 14]^2,
+//           and lineRunSliceRange over every sub-interval [kLo, kHi] of the lines in
+//           [-8, 8]^2 against the same pixels of lineBresenham; compared as pixel sets, since
+//           a run going toward -x is emitted as a left-to-right span
+//   clip    lineBresenhamClipped, circleMidpointClipped, fillCircleMidpointClipped and
+//           fillRectClipped against their unclipped kernel's output filtered to the clip
+//           rectangle, for lines and rects with corners in [-12, 12]^2 and circles and discs
+//           of radius 0..20 centered there, under rectangles that hold, cut or miss them;
+//           the pixels and both ClipStats counts (pixels emitted outside, and a rejection
+//           when none is inside) must match
+//   dda     lineDDAFixed8 against lineDDAFixed point for point, and both against the exact
+//           rounding rule floor(x0 + dx * k / n + 1/2) (computed with integers), for every
+//           pair of endpoints in [-16, 16]^2 and for lines of DDA_FIXED_EXACT_STEPS and one
+//           fewer steps in every direction, far from the origin; lineDDAFixedClipped and
+//           dashedLineDDAFixedClipped against the filtered unclipped output and ClipStats
+//           as for "clip", on the short lines and on long ones whose visible part starts
+//           far from their first pixel
+//   disc    fillCircleMidpoint against the circleMidpoint outline for radii 0..1000: one
+//           span per row, on exactly the outline's rows, from its leftmost to its rightmost
+//           pixel on that row (so the disc has no pinholes and nothing is written twice)
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "raster.h"
+
+using namespace std;
+
+struct Line { int x0, y0, x1, y1; };
+
+struct Result {
+    string kernel;
+    string shape;     // "line", "axis_line" or "circle"
+    int size;         // line length or circle radius
+    int octant;       // 0..7 for lines, -1 for circles
+    size_t primitives;
+    uint64_t pixels;
+    uint64_t checksum;
+    double nsPerPrimitive;
+    double pixelsPerSecond;
+};
+
+struct Accuracy {
+    string kernel;
+    int length;
+    size_t lines;
+    uint64_t pixels;
+    uint64_t differFromBresenham;
+    uint64_t notNearest;
+    double maxError; // pixels from the exact line position, worst axis
+};
+
+// Benchmark target: the framebuffer is large enough for every case drawn around its center
+const int FB_SIZE = 2048;
+const int CENTER = FB_SIZE / 2;
+
+bool useFramebuffer = false;
+double minSeconds = 0.1;
+Framebuffer fb;
+volatile uint64_t observed; // keeps the counting sink's work from being optimized away
+
+// Lines of the given length whose direction lies inside one octant (45 degree wedge)
+vector<Line> makeOctantLines(int length, int octant, int count) {
+    vector<Line> lines;
+    const double pi = 3.14159265358979323846;
+    for (int k = 0; k < count; ++k) {
+        double a = (octant + (k + 0.5) / count) * (pi / 4.0);
+        int dx = (int)lround(cos(a) * length);
+        int dy = (int)lround(sin(a) * length);
+        lines.push_back({ CENTER, CENTER, CENTER + dx, CENTER + dy });
+    }
+    return lines;
+}
+
+// Lines of the given length in one octant, at most 6 degrees off the axis the octant touches
+vector<Line> makeNearAxisLines(int length, int octant, int count) {
+    vector<Line> lines;
+    const double pi = 3.14159265358979323846;
+    for (int k = 0; k < count; ++k) {
+        double f = (k + 0.5) / count * (6.0 / 45.0);
+        double a = (octant % 2 == 0 ? octant + f : octant + 1 - f) * (pi / 4.0);
+        int dx = (int)lround(cos(a) * length);
+        int dy = (int)lround(sin(a) * length);
+        lines.push_back({ CENTER, CENTER, CENTER + dx, CENTER + dy });
+    }
+    return lines;
+}
+
+// Time drawAll(sink) until at least minSeconds have elapsed; keep the fastest pass
+template <class DrawAll>
+double bestSecondsPerPass(DrawAll&& drawAll) {
+    using clock = chrono::steady_clock;
+    double best = 1e30;
+    double total = 0.0;
+    int passes = 0;
+    while (total < minSeconds || passes < 3) {
+        auto t0 = clock::now();
+        if (useFramebuffer) drawAll(raster::FramebufferSink{ fb, 0xffffffffu });
+        else {
+            raster::CountingSink sink;
+            drawAll(sink);
+            observed = sink.checksum;
+        }
+        double s = chrono::duration<double>(clock::now() - t0).count();
+        best = min(best, s);
+        total += s;
+        ++passes;
+    }
+    return best;
+}
+
+template <class DrawAll>
+Result measure(const string& kernel, const string& shape, int size, int octant, size_t primitives, DrawAll&& drawAll) {
+    // counting pre-pass gives the exact pixel output regardless of the timed sink
+    raster::CountingSink count;
+    drawAll(count);
+    double s = bestSecondsPerPass(drawAll);
+    Result r;
+    r.kernel = kernel;
+    r.shape = shape;
+    r.size = size;
+    r.octant = octant;
+    r.primitives = primitives;
+    r.pixels = count.pixels;
+    r.checksum = count.checksum;
+    r.nsPerPrimitive = s * 1e9 / (double)primitives;
+    r.pixelsPerSecond = (double)count.pixels / s;
+    return r;
+}
+
+template <class Kernel>
+void benchLines(vector<Result>& out, const string& kernel, Kernel&& k) {
+    const int lengths[] = { 4, 16, 64, 256, 1000 };
+    for (int len : lengths) {
+        for (int oct = 0; oct < 8; ++oct) {
+            vector<Line> lines = makeOctantLines(len, oct, 64);
+            out.push_back(measure(kernel, "line", len, oct, lines.size(), [&](auto&& sink) {
+                for (const Line& l : lines) k(sink, l.x0, l.y0, l.x1, l.y1);
+            }));
+            vector<Line> axis = makeNearAxisLines(len, oct, 64);
+            out.push_back(measure(kernel, "axis_line", len, oct, axis.size(), [&](auto&& sink) {
+                for (const Line& l : axis) k(sink, l.x0, l.y0, l.x1, l.y1);
+            }));
+        }
+    }
+}
+
+template <class Kernel>
+void benchCircles(vector<Result>& out, const string& kernel, Kernel&& k) {
+    for (int r = 1; r <= 512; r *= 2) {
+        const int reps = 16;
+        out.push_back(measure(kernel, "circle", r, -1, reps, [&](auto&& sink) {
+            for (int i = 0; i < reps; ++i) k(sink, CENTER + (i & 3), CENTER + (i >> 2), r);
+        }));
+    }
+}
+
+// Pixel k of every line (k = steps along the major axis) against the exact position
+// x0 + dx * k / n and against lineBresenham's pixel k
+template <class Kernel>
+void measureAccuracy(vector<Accuracy>& out, const string& kernel, Kernel&& k) {
+    const int lengths[] = { 16, 256, 1000, 10000, 40000 };
+    for (int len : lengths) {
+        Accuracy a{ kernel, len, 0, 0, 0, 0, 0.0 };
+        for (int oct = 0; oct < 8; ++oct) {
+            for (const Line& l : makeOctantLines(len, oct, 16)) {
+                raster::PointCollector got, ref;
+                k(got, l.x0, l.y0, l.x1, l.y1);
+                raster::lineBresenham(ref, l.x0, l.y0, l.x1, l.y1);
+                const long long dx = l.x1 - l.x0, dy = l.y1 - l.y0;
+                const long long n = max(llabs(dx), llabs(dy));
+                ++a.lines;
+                for (size_t i = 0; i < got.points.size(); ++i) {
+                    const raster::Point& p = got.points[i];
+                    if (i >= ref.points.size() || p != ref.points[i]) ++a.differFromBresenham;
+                    // distance as a fraction with denominator n: |p * n - (x0 * n + dx * i)|
+                    long long ex = llabs((long long)p.x * n - ((long long)l.x0 * n + dx * (long long)i));
+                    long long ey = llabs((long long)p.y * n - ((long long)l.y0 * n + dy * (long long)i));
+                    long long e = max(ex, ey);
+                    if (2 * e > n) ++a.notNearest;
+                    if (n > 0) a.maxError = max(a.maxError, (double)e / (double)n);
+                }
+                a.pixels += got.points.size();
+            }
+        }
+        out.push_back(a);
+    }
+}
+
+// ----- Correctness checks -----
+
+// Outcome of one --check; mismatches are cases whose output differs from the reference
+struct Check {
+    string name;
+    uint64_t cases = 0;
+    uint64_t mismatches = 0;
+};
+
+const int CHECK_BOX = 16; // octant endpoints range over [-CHECK_BOX, CHECK_BOX]^2
+
+// Every line in the box through the kernel and its reference, compared point for point
+template <class Kernel, class Reference>
+Check checkOctantSequence(const string& name, Kernel&& k, Reference&& ref) {
+    Check c{ name };
+    raster::PointCollector got, want;
+    for (int x0 = -CHECK_BOX; x0 <= CHECK_BOX; ++x0)
+        for (int y0 = -CHECK_BOX; y0 <= CHECK_BOX; ++y0)
+            for (int x1 = -CHECK_BOX; x1 <= CHECK_BOX; ++x1)
+                for (int y1 = -CHECK_BOX; y1 <= CHECK_BOX; ++y1) {
+                    got.points.clear();
+                    want.points.clear();
+                    k(got, x0, y0, x1, y1);
+                    ref(want, x0, y0, x1, y1);
+                    ++c.cases;
+                    if (got.points != want.points) ++c.mismatches;
+                }
+    return c;
+}
+
+// The same lines, moved into a small framebuffer with a clip rectangle narrower than the box:
+// the kernel drawn through a FramebufferSink against setPixel of the reference's points. Each
+// line has its own color and neither buffer is cleared, so a stray write anywhere in the
+// buffer shows up as a difference between the two.
+template <class Kernel, class Reference>
+Check checkOctantFramebuffer(const string& name, Kernel&& k, Reference&& ref) {
+    Check c{ name };
+    const int size = 2 * CHECK_BOX + 3, offset = CHECK_BOX + 1;
+    Framebuffer got, want;
+    got.resize(size, size);
+    want.resize(size, size);
+    got.clear(0);
+    want.clear(0);
+    got.setClip(5, 3, size - 7, size - 5);
+    want.setClip(5, 3, size - 7, size - 5);
+    raster::PointCollector points;
+    uint32_t color = 0;
+    for (int x0 = -CHECK_BOX; x0 <= CHECK_BOX; ++x0)
+        for (int y0 = -CHECK_BOX; y0 <= CHECK_BOX; ++y0)
+            for (int x1 = -CHECK_BOX; x1 <= CHECK_BOX; ++x1)
+                for (int y1 = -CHECK_BOX; y1 <= CHECK_BOX; ++y1) {
+                    const int ax = x0 + offset, ay = y0 + offset, bx = x1 + offset, by = y1 + offset;
+                    ++color;
+                    k(raster::FramebufferSink{ got, color }, ax, ay, bx, by);
+                    points.points.clear();
+                    ref(points, ax, ay, bx, by);
+                    for (const raster::Point& p : points.points) want.setPixel(p.x, p.y, color);
+                    ++c.cases;
+                    if (got.pixels != want.pixels) {
+                        ++c.mismatches;
+                        got.pixels = want.pixels; // report each bad line once, not every line after it
+                    }
+                }
+    return c;
+}
+
+// Pixels in row-major order, so outputs emitted in different orders compare equal
+void sortPoints(vector<raster::Point>& v) {
+    sort(v.begin(), v.end(), [](const raster::Point& a, const raster::Point& b) { return a.y != b.y ? a.y < b.y : a.x < b.x; });
+}
+
+const int RUN_SLICE_BOX = 14;       // lineRunSlice endpoints range over [-RUN_SLICE_BOX, RUN_SLICE_BOX]^2
+const int RUN_SLICE_RANGE_BOX = 8;  // and lineRunSliceRange's, with every sub-interval of each line
+
+Check checkRunSlice() {
+    Check c{ "runslice: lineRunSlice vs lineBresenham" };
+    raster::PointCollector got, want;
+    for (int x0 = -RUN_SLICE_BOX; x0 <= RUN_SLICE_BOX; ++x0)
+        for (int y0 = -RUN_SLICE_BOX; y0 <= RUN_SLICE_BOX; ++y0)
+            for (int x1 = -RUN_SLICE_BOX; x1 <= RUN_SLICE_BOX; ++x1)
+                for (int y1 = -RUN_SLICE_BOX; y1 <= RUN_SLICE_BOX; ++y1) {
+                    got.points.clear();
+                    want.points.clear();
+                    raster::lineRunSlice(got, x0, y0, x1, y1);
+                    raster::lineBresenham(want, x0, y0, x1, y1);
+                    sortPoints(got.points);
+                    sortPoints(want.points);
+                    ++c.cases;
+                    if (got.points != want.points) ++c.mismatches;
+                }
+    return c;
+}
+
+// lineBresenham emits pixel k as its k-th point, so pixels kLo .. kHi are that slice of it
+Check checkRunSliceRange() {
+    Check c{ "runslice: lineRunSliceRange vs lineBresenham slices" };
+    raster::PointCollector got, line;
+    vector<raster::Point> want;
+    for (int x0 = -RUN_SLICE_RANGE_BOX; x0 <= RUN_SLICE_RANGE_BOX; ++x0)
+        for (int y0 = -RUN_SLICE_RANGE_BOX; y0 <= RUN_SLICE_RANGE_BOX; ++y0)
+            for (int x1 = -RUN_SLICE_RANGE_BOX; x1 <= RUN_SLICE_RANGE_BOX; ++x1)
+                for (int y1 = -RUN_SLICE_RANGE_BOX; y1 <= RUN_SLICE_RANGE_BOX; ++y1) {
+                    line.points.clear();
+                    raster::lineBresenham(line, x0, y0, x1, y1);
+                    const long long n = (long long)line.points.size() - 1;
+                    for (long long kLo = 0; kLo <= n; ++kLo)
+                        for (long long kHi = kLo; kHi <= n; ++kHi) {
+                            got.points.clear();
+                            raster::lineRunSliceRange(got, x0, y0, x1, y1, kLo, kHi);
+                            want.assign(line.points.begin() + kLo, line.points.begin() + kHi + 1);
+                            sortPoints(got.points);
+                            sortPoints(want);
+                            ++c.cases;
+                            if (got.points != want) ++c.mismatches;
+                        }
+                }
+    return c;
+}
+
+const raster::ClipRect CHECK_CLIPS[] = {
+    { -20, -20, 20, 20 }, // holds everything
+    { -5, -4, 6, 7 },     // cuts most primitives
+    { 3, -30, 3, 30 },    // one column
+    { -30, -2, 30, -2 },  // one row
+    { 13, 13, 20, 20 },   // misses most
+};
+const int CLIP_BOX = 12;       // line and rect corners, circle centers in [-CLIP_BOX, CLIP_BOX]^2
+const int CLIP_MAX_RADIUS = 20;
+
+// One primitive under rect c: clipped(sink, c, stats) against unclipped(sink) filtered to c,
+// comparing the pixels (as sorted lists, duplicates kept) and the ClipStats it adds
+template <class Clipped, class Unclipped>
+void compareClipped(Check& check, const raster::ClipRect& c, Clipped&& clipped, Unclipped&& unclipped) {
+    raster::PointCollector got, all;
+    raster::ClipStats stats;
+    clipped(got, c, stats);
+    unclipped(all);
+    vector<raster::Point> want;
+    for (const raster::Point& p : all.points)
+        if (c.contains(p.x, p.y)) want.push_back(p);
+    const uint64_t clippedPixels = all.points.size() - want.size();
+    const uint64_t rejected = want.empty() && !all.points.empty() ? 1 : 0;
+    sortPoints(got.points);
+    sortPoints(want);
+    ++check.cases;
+    if (got.points != want || stats.clippedPixels != clippedPixels || stats.rejected != rejected) ++check.mismatches;
+}
+
+Check checkClipLines() {
+    Check check{ "clip: lineBresenhamClipped" };
+    for (const raster::ClipRect& c : CHECK_CLIPS)
+        for (int x0 = -CLIP_BOX; x0 <= CLIP_BOX; ++x0)
+            for (int y0 = -CLIP_BOX; y0 <= CLIP_BOX; ++y0)
+                for (int x1 = -CLIP_BOX; x1 <= CLIP_BOX; ++x1)
+                    for (int y1 = -CLIP_BOX; y1 <= CLIP_BOX; ++y1)
+                        compareClipped(check, c,
+                            [&](auto& s, const raster::ClipRect& r, raster::ClipStats& st) { raster::lineBresenhamClipped(s, r, st, x0, y0, x1, y1); },
+                            [&](auto& s) { raster::lineBresenham(s, x0, y0, x1, y1); });
+    return check;
+}
+
+Check checkClipCircles() {
+    Check check{ "clip: circleMidpointClipped, fillCircleMidpointClipped" };
+    for (const raster::ClipRect& c : CHECK_CLIPS)
+        for (int xc = -CLIP_BOX; xc <= CLIP_BOX; ++xc)
+            for (int yc = -CLIP_BOX; yc <= CLIP_BOX; ++yc)
+                for (int r = 0; r <= CLIP_MAX_RADIUS; ++r) {
+                    compareClipped(check, c,
+                        [&](auto& s, const raster::ClipRect& cr, raster::ClipStats& st) { raster::circleMidpointClipped(s, cr, st, xc, yc, r); },
+                        [&](auto& s) { raster::circleMidpoint(s, xc, yc, r); });
+                    compareClipped(check, c,
+                        [&](auto& s, const raster::ClipRect& cr, raster::ClipStats& st) { raster::fillCircleMidpointClipped(s, cr, st, xc, yc, r); },
+                        [&](auto& s) { raster::fillCircleMidpoint(s, xc, yc, r); });
+                }
+    return check;
+}
+
+Check checkClipRects() {
+    Check check{ "clip: fillRectClipped" };
+    for (const raster::ClipRect& c : CHECK_CLIPS)
+        for (int x0 = -CLIP_BOX; x0 <= CLIP_BOX; ++x0)
+            for (int y0 = -CLIP_BOX; y0 <= CLIP_BOX; ++y0)
+                for (int x1 = x0; x1 <= CLIP_BOX; ++x1)
+                    for (int y1 = y0; y1 <= CLIP_BOX; ++y1)
+                        compareClipped(check, c,
+                            [&](auto& s, const raster::ClipRect& r, raster::ClipStats& st) { raster::fillRectClipped(s, r, st, x0, y0, x1, y1); },
+                            [&](auto& s) { raster::fillRect(s, x0, y0, x1, y1); });
+    return check;
+}
+
+// Pixel k of the line per the fixed-point DDA's rule: floor(x0 + dx * k / n + 1/2) on each
+// axis, i.e. floor((2 * (x0 * n + dx * k) + n) / (2 * n))
+raster::Point ddaExactPixel(int x0, int y0, int x1, int y1, long long k) {
+    const long long dx = (long long)x1 - x0, dy = (long long)y1 - y0;
+    const long long n = max(llabs(dx), llabs(dy));
+    if (n == 0) return { x0, y0 };
+    return { (int)raster::floorDiv(2 * ((long long)x0 * n + dx * k) + n, 2 * n),
+             (int)raster::floorDiv(2 * ((long long)y0 * n + dy * k) + n, 2 * n) };
+}
+
+// Lines the DDA checks run beyond the box: n = DDA_FIXED_EXACT_STEPS and one fewer, minor
+// extents from 0 to n (small, near n / 2 and near n, and spread between), in all eight
+// octants, starting far from the origin
+vector<Line> makeLongDDALines() {
+    vector<Line> lines;
+    for (int n : { raster::DDA_FIXED_EXACT_STEPS - 1, raster::DDA_FIXED_EXACT_STEPS })
+        for (int m : { 0, 1, 2, 3, n / 2 - 1, n / 2, n / 2 + 1, n - 1, n, 7919, 12345, 30011 })
+            for (int oct = 0; oct < 8; ++oct) {
+                const int sx = oct & 1 ? -1 : 1, sy = oct & 2 ? -1 : 1;
+                const int dx = sx * (oct & 4 ? m : n), dy = sy * (oct & 4 ? n : m);
+                const int x0 = -1000003 + 7 * oct, y0 = 999983 - 13 * m % 101;
+                lines.push_back({ x0, y0, x0 + dx, y0 + dy });
+            }
+    return lines;
+}
+
+Check checkDDAFixed8() {
+    Check c{ "dda: lineDDAFixed8 vs lineDDAFixed" };
+    raster::PointCollector got, want;
+    auto one = [&](const Line& l) {
+        got.points.clear();
+        want.points.clear();
+        raster::lineDDAFixed8(got, l.x0, l.y0, l.x1, l.y1);
+        raster::lineDDAFixed(want, l.x0, l.y0, l.x1, l.y1);
+        ++c.cases;
+        if (got.points != want.points) ++c.mismatches;
+    };
+    for (int x0 = -CHECK_BOX; x0 <= CHECK_BOX; ++x0)
+        for (int y0 = -CHECK_BOX; y0 <= CHECK_BOX; ++y0)
+            for (int x1 = -CHECK_BOX; x1 <= CHECK_BOX; ++x1)
+                for (int y1 = -CHECK_BOX; y1 <= CHECK_BOX; ++y1) one({ x0, y0, x1, y1 });
+    for (const Line& l : makeLongDDALines()) one(l);
+    return c;
+}
+
+template <class Kernel>
+Check checkDDARule(const string& name, Kernel&& k) {
+    Check c{ name };
+    raster::PointCollector got;
+    auto one = [&](const Line& l) {
+        got.points.clear();
+        k(got, l.x0, l.y0, l.x1, l.y1);
+        const long long n = max(llabs((long long)l.x1 - l.x0), llabs((long long)l.y1 - l.y0));
+        bool ok = (long long)got.points.size() == n + 1;
+        for (long long i = 0; ok && i <= n; ++i) ok = got.points[i] == ddaExactPixel(l.x0, l.y0, l.x1, l.y1, i);
+        ++c.cases;
+        if (!ok) ++c.mismatches;
+    };
+    for (int x0 = -CHECK_BOX; x0 <= CHECK_BOX; ++x0)
+        for (int y0 = -CHECK_BOX; y0 <= CHECK_BOX; ++y0)
+            for (int x1 = -CHECK_BOX; x1 <= CHECK_BOX; ++x1)
+                for (int y1 = -CHECK_BOX; y1 <= CHECK_BOX; ++y1) one({ x0, y0, x1, y1 });
+    for (const Line& l : makeLongDDALines()) one(l);
+    return c;
+}
+
+const int DDA_CLIP_BOX = 10;          // short clipped DDA lines have endpoints in [-DDA_CLIP_BOX, DDA_CLIP_BOX]^2
+const int DDA_CLIP_DASHES[] = { 1, 3 };
+
+// Clipped DDA lines: the short ones under CHECK_CLIPS, then long random lines (seeded) under
+// a rect far from their start, so the clipped kernels jump thousands of pixels ahead
+Check checkDDAClipped() {
+    Check check{ "dda: lineDDAFixedClipped, dashedLineDDAFixedClipped" };
+    auto one = [&](const raster::ClipRect& c, const Line& l) {
+        compareClipped(check, c,
+            [&](auto& s, const raster::ClipRect& r, raster::ClipStats& st) { raster::lineDDAFixedClipped(s, r, st, l.x0, l.y0, l.x1, l.y1); },
+            [&](auto& s) { raster::lineDDAFixed(s, l.x0, l.y0, l.x1, l.y1); });
+        for (int dash : DDA_CLIP_DASHES)
+            compareClipped(check, c,
+                [&](auto& s, const raster::ClipRect& r, raster::ClipStats& st) { raster::dashedLineDDAFixedClipped(s, r, st, l.x0, l.y0, l.x1, l.y1, dash); },
+                [&](auto& s) { raster::dashedLineDDAFixed(s, l.x0, l.y0, l.x1, l.y1, dash); });
+    };
+    for (const raster::ClipRect& c : CHECK_CLIPS)
+        for (int x0 = -DDA_CLIP_BOX; x0 <= DDA_CLIP_BOX; ++x0)
+            for (int y0 = -DDA_CLIP_BOX; y0 <= DDA_CLIP_BOX; ++y0)
+                for (int x1 = -DDA_CLIP_BOX; x1 <= DDA_CLIP_BOX; ++x1)
+                    for (int y1 = -DDA_CLIP_BOX; y1 <= DDA_CLIP_BOX; ++y1) one(c, { x0, y0, x1, y1 });
+    mt19937 rng(25);
+    uniform_int_distribution<int> far(-20000, 20000);
+    const raster::ClipRect c = { -50, -40, 60, 70 };
+    for (int i = 0; i < 2000; ++i) {
+        // from a point far away, through (or past) the rect, to the other side
+        const int ax = far(rng), ay = far(rng);
+        const int bx = (int)rng() % 120 - 60, by = (int)rng() % 120 - 50;
+        one(c, { ax, ay, 2 * bx - ax, 2 * by - ay });
+    }
+    return check;
+}
+
+// Records the spans a fill kernel emits; single plots count as one-pixel spans
+struct SpanCollector {
+    struct Span { int x0, x1, y; };
+    vector<Span> spans;
+    void plot(int x, int y) { spans.push_back({ x, x, y }); }
+    void span(int x0, int x1, int y) { spans.push_back({ x0, x1, y }); }
+};
+
+// Each radius at a few centers (odd, even and negative coordinates); a disc is a mismatch
+// unless its spans are exactly the outline's rows, each filled once from end to end
+Check checkDisc() {
+    Check c{ "disc: fillCircleMidpoint vs circleMidpoint outline" };
+    const raster::Point centers[] = { { 0, 0 }, { 7, -3 }, { -450, 351 } };
+    for (int r = 0; r <= 1000; ++r) {
+        for (const raster::Point& ctr : centers) {
+            raster::PointCollector outline;
+            raster::circleMidpoint(outline, ctr.x, ctr.y, r);
+            // outline extent of row y, indexed by y - (ctr.y - r)
+            vector<int> lo(2 * r + 1, INT_MAX), hi(2 * r + 1, INT_MIN);
+            for (const raster::Point& p : outline.points) {
+                int i = p.y - (ctr.y - r);
+                lo[i] = min(lo[i], p.x);
+                hi[i] = max(hi[i], p.x);
+            }
+            SpanCollector disc;
+            raster::fillCircleMidpoint(disc, ctr.x, ctr.y, r);
+            vector<int> seen(2 * r + 1, 0);
+            bool ok = true;
+            for (const SpanCollector::Span& s : disc.spans) {
+                int i = s.y - (ctr.y - r);
+                if (i < 0 || i > 2 * r || seen[i]++ || s.x0 != lo[i] || s.x1 != hi[i]) ok = false;
+            }
+            for (int i = 0; i <= 2 * r; ++i)
+                if (!seen[i] && lo[i] != INT_MAX) ok = false;
+            ++c.cases;
+            if (!ok) ++c.mismatches;
+        }
+    }
+    return c;
+}
+
+void runChecks(vector<Check>& out) {
+    auto octant = [](auto&& s, int x0, int y0, int x1, int y1) { raster::lineBresenhamOctant(s, x0, y0, x1, y1); };
+    auto majorOctant = [](auto&& s, int x0, int y0, int x1, int y1) { raster::lineBresenhamMajorAxisOctant(s, x0, y0, x1, y1); };
+    auto bresenham = [](auto&& s, int x0, int y0, int x1, int y1) { raster::lineBresenham(s, x0, y0, x1, y1); };
+    auto majorAxis = [](auto&& s, int x0, int y0, int x1, int y1) { raster::lineBresenhamMajorAxis(s, x0, y0, x1, y1); };
+    out.push_back(checkOctantSequence("octant: lineBresenhamOctant points", octant, bresenham));
+    out.push_back(checkOctantSequence("octant: lineBresenhamMajorAxisOctant points", majorOctant, majorAxis));
+    out.push_back(checkOctantFramebuffer("octant: lineBresenhamOctant framebuffer", octant, bresenham));
+    out.push_back(checkOctantFramebuffer("octant: lineBresenhamMajorAxisOctant framebuffer", majorOctant, majorAxis));
+    out.push_back(checkRunSlice());
+    out.push_back(checkRunSliceRange());
+    out.push_back(checkClipLines());
+    out.push_back(checkClipCircles());
+    out.push_back(checkClipRects());
+    out.push_back(checkDDAFixed8());
+    out.push_back(checkDDARule("dda: lineDDAFixed vs exact rounding rule", [](auto& s, int x0, int y0, int x1, int y1) { raster::lineDDAFixed(s, x0, y0, x1, y1); }));
+    out.push_back(checkDDARule("dda: lineDDAFixed8 vs exact rounding rule", [](auto& s, int x0, int y0, int x1, int y1) { raster::lineDDAFixed8(s, x0, y0, x1, y1); }));
+    out.push_back(checkDDAClipped());
+    out.push_back(checkDisc());
+}
+
+void writeJson(ostream& os, const vector<Result>& results, const vector<Accuracy>& accuracy) {
+    os << "{\n";
+    os << "  \"benchmark\": \"raster_bench\",\n";
+    os << "  \"sink\": \"" << (useFramebuffer ? "framebuffer" : "counting") << "\",\n";
+    os << "  \"min_time_ms\": " << minSeconds * 1000.0 << ",\n";
+    os << "  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        char buf[512];
+        snprintf(buf, sizeof(buf),
+            "    {\"kernel\": \"%s\", \"shape\": \"%s\", \"size\": %d, \"octant\": %d, "
+            "\"primitives\": %zu, \"pixels\": %llu, \"checksum\": %llu, "
+            "\"ns_per_primitive\": %.2f, \"pixels_per_second\": %.0f}%s\n",
+            r.kernel.c_str(), r.shape.c_str(), r.size, r.octant, r.primitives,
+            (unsigned long long)r.pixels, (unsigned long long)r.checksum,
+            r.nsPerPrimitive, r.pixelsPerSecond, i + 1 < results.size() ? "," : "");
+        os << buf;
+    }
+    os << "  ],\n";
+    os << "  \"dda_kernel\": \"" << raster::ddaKernelName() << "\",\n";
+    os << "  \"accuracy\": [\n";
+    for (size_t i = 0; i < accuracy.size(); ++i) {
+        const Accuracy& a = accuracy[i];
+        char buf[512];
+        snprintf(buf, sizeof(buf),
+            "    {\"kernel\": \"%s\", \"length\": %d, \"lines\": %zu, \"pixels\": %llu, "
+            "\"differ_from_bresenham\": %llu, \"not_nearest\": %llu, \"max_error\": %.4f}%s\n",
+            a.kernel.c_str(), a.length, a.lines, (unsigned long long)a.pixels,
+            (unsigned long long)a.differFromBresenham, (unsigned long long)a.notNearest, a.maxError,
+            i + 1 < accuracy.size() ? "," : "");
+        os << buf;
+    }
+    os << "  ]\n";
+    os << "}\n";
+}
+
+int main(int argc, char** argv) {
+    string outPath;
+    bool check = false;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--check") == 0) check = true;
+        else if (strcmp(argv[i], "--sink") == 0 && i + 1 < argc) {
+            string s = argv[++i];
+            if (s == "framebuffer") useFramebuffer = true;
+            else if (s != "counting") { cerr << "unknown sink: " << s << "\n"; return 1; }
+        }
+        else if (strcmp(argv[i], "--min-time") == 0 && i + 1 < argc) minSeconds = atof(argv[++i]) / 1000.0;
+        else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) outPath = argv[++i];
+        else {
+            cerr << "Usage: " << argv[0] << " [--sink counting|framebuffer] [--min-time ms] [--out file.json]\n";
+            cerr << "       " << argv[0] << " --check\n";
+            return 1;
+        }
+    }
+    if (check) {
+        vector<Check> checks;
+        runChecks(checks);
+        bool ok = true;
+        for (const Check& c : checks) {
+            printf("%-52s %10llu cases, %llu mismatches\n", c.name.c_str(), (unsigned long long)c.cases, (unsigned long long)c.mismatches);
+            ok = ok && c.mismatches == 0;
+        }
+        printf("%s\n", ok ? "all checks passed" : "CHECKS FAILED");
+        return ok ? 0 : 1;
+    }
+    if (useFramebuffer) fb.resize(FB_SIZE, FB_SIZE);
+
+    vector<Result> results;
+    benchLines(results, "lineDDA", [](auto&& s, int x0, int y0, int x1, int y1) { raster::lineDDA(s, x0, y0, x1, y1); });
+    benchLines(results, "lineDDAFixed", [](auto&& s, int x0, int y0, int x1, int y1) { raster::lineDDAFixed(s, x0, y0, x1, y1); });
+    benchLines(results, "lineDDAFixed8", [](auto&& s, int x0, int y0, int x1, int y1) { raster::lineDDAFixed8(s, x0, y0, x1, y1); });
+    benchLines(results, "lineBresenham", [](auto&& s, int x0, int y0, int x1, int y1) { raster::lineBresenham(s, x0, y0, x1, y1); });
+    benchLines(results, "lineBresenhamMajorAxis", [](auto&& s, int x0, int y0, int x1, int y1) { raster::lineBresenhamMajorAxis(s, x0, y0, x1, y1); });
+    benchLines(results, "lineBresenhamOctant", [](auto&& s, int x0, int y0, int x1, int y1) { raster::lineBresenhamOctant(s, x0, y0, x1, y1); });
+    benchLines(results, "lineBresenhamMajorAxisOctant", [](auto&& s, int x0, int y0, int x1, int y1) { raster::lineBresenhamMajorAxisOctant(s, x0, y0, x1, y1); });
+    benchLines(results, "lineRunSlice", [](auto&& s, int x0, int y0, int x1, int y1) { raster::lineRunSlice(s, x0, y0, x1, y1); });
+    benchCircles(results, "circleMidpoint", [](auto&& s, int xc, int yc, int r) { raster::circleMidpoint(s, xc, yc, r); });
+    benchCircles(results, "circleBresenham", [](auto&& s, int xc, int yc, int r) { raster::circleBresenham(s, xc, yc, r); });
+    benchCircles(results, "fillCircleMidpoint", [](auto&& s, int xc, int yc, int r) { raster::fillCircleMidpoint(s, xc, yc, r); });
+
+    vector<Accuracy> accuracy;
+    measureAccuracy(accuracy, "lineDDA", [](auto&& s, int x0, int y0, int x1, int y1) { raster::lineDDA(s, x0, y0, x1, y1); });
+    measureAccuracy(accuracy, "lineDDAFixed", [](auto&& s, int x0, int y0, int x1, int y1) { raster::lineDDAFixed(s, x0, y0, x1, y1); });
+    measureAccuracy(accuracy, "lineDDAFixed8", [](auto&& s, int x0, int y0, int x1, int y1) { raster::lineDDAFixed8(s, x0, y0, x1, y1); });
+
+    if (outPath.empty()) {
+        writeJson(cout, results, accuracy);
+    }
+    else {
+        ofstream f(outPath);
+        if (!f) { cerr << "cannot write " << outPath << "\n"; return 1; }
+        writeJson(f, results, accuracy);
+        cerr << "wrote " << results.size() << " results to " << outPath << "\n";
+    }
+    return 0;
+}
@@ -0,0 +1,176 @@
+// replay.h
+// Deterministic runs for the games: seeded random streams, input recording and replay.
+//
+// Each subsystem that needs randomness (bubble spawning, splits, target placement, ...)
+// owns an Rng seeded from one run seed and its own name, so adding draws to one subsystem
+// does not shift the sequence another one sees. A run is then fully described by its seed,
+// its options and the input the simulation consumed at each step; InputRecorder writes
+// those to a text file and ReplayLog reads it back, so a replay can drive the simulation
+// headless, as fast as it will go, with the same result as the recorded run.
+//
+// File format (text, one item per line):
+//   replay 1 <game>
+//   seed <n>
+//   set <option> <value>            (any number)
+//   events
+//   <step> <time> <type> <a> <b>    (any number; type is one character, a/b its arguments)
+//   final <steps> <score> <checksum>
+// <step> is the simulation step the event was applied before and <time> the wall-clock
+// seconds since recording started. The final line lets a replay check it reproduced the
+// recorded state exactly.
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// ----- Seeded random streams -----
+
+inline uint64_t splitmix64(uint64_t& x) {
+    uint64_t z = (x += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+// xorshift64* generator; small, fast and good enough for gameplay
+struct Rng {
+    uint64_t state = 1;
+
+    Rng() = default;
+    explicit Rng(uint64_t seed) { reseed(seed); }
+
+    void reseed(uint64_t seed) {
+        state = splitmix64(seed);
+        if (state == 0) state = 1;
+    }
+
+    // stream for one subsystem of a run: the run seed mixed with the subsystem's name
+    void reseed(uint64_t runSeed, const char* subsystem) {
+        uint64_t h = 0xcbf29ce484222325ull; // FNV-1a
+        for (const char* c = subsystem; *c; ++c) h = (h ^ (uint8_t)*c) * 0x100000001b3ull;
+        reseed(runSeed ^ h);
+    }
+
+    uint32_t next() {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return (uint32_t)((state * 0x2545f4914f6cdd1dull) >> 32);
+    }
+
+    // uniform in [0, n) (replaces rand() % n)
+    int below(int n) { return n > 0 ? (int)(((uint64_t)next() * (uint32_t)n) >> 32) : 0; }
+};
+
+// Order-sensitive hash of simulation state, for comparing runs
+struct StateHash {
+    uint64_t h = 0xcbf29ce484222325ull;
+
+    void add(uint64_t v) {
+        for (int i = 0; i < 8; ++i) h = (h ^ ((v >> (8 * i)) & 0xff)) * 0x100000001b3ull;
+    }
+    void add(float f) {
+        uint32_t bits;
+        memcpy(&bits, &f, sizeof bits);
+        add((uint64_t)bits);
+    }
+};
+
+// ----- Input log -----
+
+struct InputEvent {
+    uint64_t step;
+    double time;
+    char type;
+    double a, b;
+};
+
+struct InputRecorder {
+    FILE* file = nullptr;
+
+    bool open(const char* path, const char* game, uint64_t seed) {
+        file = fopen(path, "w");
+        if (!file) return false;
+        fprintf(file, "replay 1 %s\nseed %llu\n", game, (unsigned long long)seed);
+        return true;
+    }
+
+    bool active() const { return file != nullptr; }
+
+    void option(const char* name, double value) {
+        if (file) fprintf(file, "set %s %.17g\n", name, value);
+    }
+
+    // call after the options, before the first event
+    void beginEvents() {
+        if (file) fprintf(file, "events\n");
+    }
+
+    // doubles are written with 17 significant digits so they read back bit-exact
+    void event(uint64_t step, double time, char type, double a = 0.0, double b = 0.0) {
+        if (file) fprintf(file, "%llu %.6f %c %.17g %.17g\n", (unsigned long long)step, time, type, a, b);
+    }
+
+    void finish(uint64_t steps, long long score, uint64_t checksum) {
+        if (!file) return;
+        fprintf(file, "final %llu %lld %016llx\n", (unsigned long long)steps, score, (unsigned long long)checksum);
+        fclose(file);
+        file = nullptr;
+    }
+};
+
+struct ReplayLog {
+    std::string game;
+    uint64_t seed = 0;
+    std::vector<std::pair<std::string, double>> options;
+    std::vector<InputEvent> events;
+    bool hasFinal = false;
+    uint64_t finalSteps = 0;
+    long long finalScore = 0;
+    uint64_t finalChecksum = 0;
+
+    // returns false with a message in error if the file is missing or malformed
+    bool load(const char* path, const char* expectedGame, std::string& error) {
+        FILE* f = fopen(path, "r");
+        if (!f) { error = std::string("cannot open ") + path; return false; }
+        char line[512];
+        int version = 0;
+        char name[128] = "";
+        bool inEvents = false;
+        bool ok = fgets(line, sizeof line, f) && sscanf(line, "replay %d %127s", &version, name) == 2 && version == 1;
+        if (!ok) error = "not a version 1 replay file";
+        game = name;
+        if (ok && game != expectedGame) { error = "recorded by " + game; ok = false; }
+        while (ok && fgets(line, sizeof line, f)) {
+            unsigned long long u0, u1;
+            long long score;
+            double a, b, t;
+            char type;
+            char key[128];
+            if (inEvents && sscanf(line, "%llu %lf %c %lf %lf", &u0, &t, &type, &a, &b) == 5) events.push_back({ u0, t, type, a, b });
+            else if (sscanf(line, "final %llu %lld %llx", &u0, &score, &u1) == 3) {
+                hasFinal = true;
+                finalSteps = u0;
+                finalScore = score;
+                finalChecksum = u1;
+            }
+            else if (!inEvents && sscanf(line, "seed %llu", &u0) == 1) seed = u0;
+            else if (!inEvents && sscanf(line, "set %127s %lf", key, &a) == 2) options.push_back({ key, a });
+            else if (!inEvents && strncmp(line, "events", 6) == 0) inEvents = true;
+            else if (line[0] != '\n') { error = std::string("bad line: ") + line; ok = false; }
+        }
+        fclose(f);
+        return ok;
+    }
+
+    // recorded value of an option, or fallback
+    double option(const char* name, double fallback) const {
+        for (const auto& o : options)
+            if (o.first == name) return o.second;
+        return fallback;
+    }
+};
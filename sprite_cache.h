@@ -0,0 +1,185 @@
+// sprite_cache.h
+// Pre-rasterized bubble sprites for the 2D shooter's framebuffer backend.
+//
+// A bubble's pixels depend only on its depth-scaled radius and its colors. Which layer
+// (fill, highlight or outline) covers each pixel depends on the radius alone, so every
+// distinct radius is rasterized once with the same kernels the direct path uses
+// (rasterizeBubble) and stored as a run-length encoded coverage mask: each run is a
+// horizontal stretch of one layer. The bubble's colors are applied as a tint when the
+// mask is blitted, so bubbles of any color share one sprite per radius. A blit is one
+// clipped span fill per run, with no circle arithmetic, no per-pixel clipping and no
+// overdraw between layers, and its output is pixel-identical to the direct path.
+//
+// Masks are kept in least-recently-used order under a byte ceiling; when an insertion
+// pushes the total over the ceiling the oldest masks are evicted.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+#include "framebuffer.h"
+#include "raster.h"
+
+// Packed colors of a bubble's layers, indexed by SpriteRun::layer
+struct BubblePalette {
+    enum { FILL, HIGHLIGHT, OUTLINE };
+    uint32_t layer[3];
+};
+
+// Filled disc, highlight toward the top-left, outline (the drawBubbleClassic layers)
+inline void rasterizeBubble(Framebuffer& fb, int xc, int yc, int r, const BubblePalette& p) {
+    raster::fillCircleMidpoint(raster::FramebufferSink{ fb, p.layer[BubblePalette::FILL] }, xc, yc, r);
+    raster::fillCircleMidpoint(raster::FramebufferSink{ fb, p.layer[BubblePalette::HIGHLIGHT] },
+        xc - r / 3, yc + r / 3, std::max(1, r / 6));
+    raster::circleMidpoint(raster::FramebufferSink{ fb, p.layer[BubblePalette::OUTLINE] }, xc, yc, r);
+}
+
+// One horizontal run of a mask, relative to the bubble center
+struct SpriteRun {
+    int16_t dy, dx;
+    uint16_t len;
+    uint16_t layer;
+};
+
+struct BubbleSprite {
+    int extent = 0; // every run lies within [-extent, extent] of the center on both axes
+    std::vector<SpriteRun> runs;
+};
+
+// Blit clipped to c (inclusive, inside the framebuffer); the framebuffer's own clip
+// rectangle is not consulted, so threads can blit disjoint rectangles of one framebuffer
+inline void blitSprite(Framebuffer& fb, const BubbleSprite& s, int xc, int yc, const BubblePalette& p, const raster::ClipRect& c) {
+    const int e = s.extent;
+    if (xc - e < c.x0 || yc - e < c.y0 || xc + e > c.x1 || yc + e > c.y1) {
+        // partly outside the clip rectangle: clip the runs on the rows inside it (runs are
+        // stored row by row in increasing dy)
+        auto run = std::lower_bound(s.runs.begin(), s.runs.end(), c.y0 - yc,
+            [](const SpriteRun& r, int dy) { return r.dy < dy; });
+        for (; run != s.runs.end() && yc + run->dy <= c.y1; ++run) {
+            int y = yc + run->dy;
+            int x0 = std::max(xc + run->dx, c.x0);
+            int x1 = std::min(xc + run->dx + run->len - 1, c.x1);
+            if (x0 <= x1) std::fill_n(fb.row(y) + x0, x1 - x0 + 1, p.layer[run->layer]);
+        }
+        return;
+    }
+    // wholly inside: no clipping
+    uint32_t* center = fb.row(yc) + xc;
+    const int stride = fb.width;
+    for (const SpriteRun& run : s.runs) {
+        uint32_t* d = center + (ptrdiff_t)run.dy * stride + run.dx;
+        const uint32_t c = p.layer[run.layer];
+        std::fill_n(d, run.len, c);
+    }
+}
+
+inline void blitSprite(Framebuffer& fb, const BubbleSprite& s, int xc, int yc, const BubblePalette& p) {
+    blitSprite(fb, s, xc, yc, p, raster::ClipRect{ fb.clipX0, fb.clipY0, fb.clipX1, fb.clipY1 });
+}
+
+struct SpriteCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    size_t bytes = 0;
+    size_t entries = 0;
+
+    double hitRate() const { return hits + misses ? (double)hits / (double)(hits + misses) : 0.0; }
+};
+
+struct BubbleSpriteCache {
+    struct Entry {
+        int radius;
+        size_t bytes;
+        BubbleSprite sprite;
+    };
+
+    size_t maxBytes = 16u << 20;
+    bool evictionsHeld = false;
+    std::list<Entry> lru; // most recently used first
+    std::unordered_map<int, std::list<Entry>::iterator> index;
+    SpriteCacheStats stats;
+    Framebuffer scratch; // reused canvas for rasterizing misses
+
+    void setCapacity(size_t bytes) {
+        maxBytes = bytes;
+        evictToFit();
+    }
+
+    void clear() {
+        lru.clear();
+        index.clear();
+        stats.bytes = 0;
+        stats.entries = 0;
+    }
+
+    // While held, nothing is evicted, so every reference get() hands out stays valid (a
+    // frame recorded for later, parallel rasterization); releasing trims to the ceiling.
+    void holdEvictions(bool hold) {
+        evictionsHeld = hold;
+        if (!hold) evictToFit();
+    }
+
+    // The mask for radius r, rasterized on a miss. The reference stays valid until the next
+    // call (which may evict it) unless evictions are held.
+    const BubbleSprite& get(int r) {
+        auto it = index.find(r);
+        if (it != index.end()) {
+            ++stats.hits;
+            lru.splice(lru.begin(), lru, it->second);
+            return it->second->sprite;
+        }
+        ++stats.misses;
+        lru.push_front({ r, 0, build(r) });
+        Entry& e = lru.front();
+        // runs plus list node, hash node and bucket overhead
+        e.bytes = e.sprite.runs.capacity() * sizeof(SpriteRun) + sizeof(Entry) + 4 * sizeof(void*) + 32;
+        index[r] = lru.begin();
+        stats.bytes += e.bytes;
+        ++stats.entries;
+        evictToFit();
+        return e.sprite;
+    }
+
+    // drop least recently used sprites until under the ceiling; the newest one always stays
+    void evictToFit() {
+        while (!evictionsHeld && stats.bytes > maxBytes && lru.size() > 1) {
+            const Entry& e = lru.back();
+            stats.bytes -= e.bytes;
+            --stats.entries;
+            ++stats.evictions;
+            index.erase(e.radius);
+            lru.pop_back();
+        }
+    }
+
+    BubbleSprite build(int r) {
+        // one pixel of margin: tiny highlights may poke one pixel past the disc
+        const int half = std::max(r, 0) + 1;
+        const int size = 2 * half + 1;
+        if (scratch.width < size || scratch.height < size) scratch.resize(size, size);
+        // rasterize layer ids + 1 instead of colors; 0 = not covered
+        for (int y = 0; y < size; ++y) std::fill_n(scratch.row(y), size, 0u);
+        rasterizeBubble(scratch, half, half, r, BubblePalette{ { 1u, 2u, 3u } });
+
+        BubbleSprite s;
+        s.extent = half;
+        for (int y = 0; y < size; ++y) {
+            const uint32_t* row = scratch.row(y);
+            int x = 0;
+            while (x < size) {
+                if (row[x] == 0u) { ++x; continue; }
+                int start = x;
+                while (x < size && row[x] == row[start]) ++x;
+                s.runs.push_back({ (int16_t)(y - half), (int16_t)(start - half), (uint16_t)(x - start), (uint16_t)(row[start] - 1) });
+            }
+        }
+        s.runs.shrink_to_fit();
+        return s;
+    }
+};
@@ -0,0 +1,87 @@
+// static_layers.h
+// Cached background layer for the 2D shooter: decorations that never change between
+// frames (the grid, any other static scenery) are rasterized once into their own
+// Framebuffer and composited under the dynamic layer every frame.
+//
+// Decorations are registered by name with a draw callback and a sort key; the layer is
+// rebuilt only when it is invalidated: a decoration added or removed, a new background
+// color (theme change) or a new target size. Compositing is a straight copy of the cached
+// pixels, which costs the same as the clear it replaces.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "framebuffer.h"
+
+struct StaticLayer {
+    struct Decoration {
+        std::string name;
+        int order; // lower orders are drawn first
+        std::function<void(Framebuffer&)> draw;
+    };
+
+    std::vector<Decoration> decorations;
+    Framebuffer pixels;
+    uint32_t background = 0xff000000u;
+    bool dirty = true;
+    uint64_t rebuilds = 0;
+
+    // register (or replace) a decoration
+    void add(const std::string& name, int order, std::function<void(Framebuffer&)> draw) {
+        remove(name);
+        decorations.push_back({ name, order, std::move(draw) });
+        std::stable_sort(decorations.begin(), decorations.end(),
+            [](const Decoration& a, const Decoration& b) { return a.order < b.order; });
+        dirty = true;
+    }
+
+    void remove(const std::string& name) {
+        auto it = std::remove_if(decorations.begin(), decorations.end(), [&](const Decoration& d) { return d.name == name; });
+        if (it != decorations.end()) {
+            decorations.erase(it, decorations.end());
+            dirty = true;
+        }
+    }
+
+    void setBackground(uint32_t c) {
+        if (c != background) { background = c; dirty = true; }
+    }
+
+    // match the render target; a size change invalidates the layer
+    void resize(int w, int h) {
+        if (w != pixels.width || h != pixels.height) { pixels.resize(w, h); dirty = true; }
+    }
+
+    // decorations that read external state (colors, positions) call this when it changes
+    void invalidate() { dirty = true; }
+
+    // rebuild if invalidated; returns true when the pixels changed
+    bool update() {
+        if (!dirty) return false;
+        pixels.clear(background);
+        for (const Decoration& d : decorations) d.draw(pixels);
+        dirty = false;
+        ++rebuilds;
+        return true;
+    }
+
+    // copy the layer into a target of the same size (replaces clearing it)
+    void composite(Framebuffer& dst) const {
+        if (dst.pixels.size() != pixels.pixels.size()) return;
+        std::copy(pixels.pixels.begin(), pixels.pixels.end(), dst.pixels.begin());
+    }
+
+    // copy only the inclusive rectangle [x0, x1] x [y0, y1] (restores a dirty region)
+    void composite(Framebuffer& dst, int x0, int y0, int x1, int y1) const {
+        if (dst.pixels.size() != pixels.pixels.size()) return;
+        x0 = std::max(x0, 0); y0 = std::max(y0, 0);
+        x1 = std::min(x1, pixels.width - 1); y1 = std::min(y1, pixels.height - 1);
+        if (x0 > x1) return;
+        for (int y = y0; y <= y1; ++y) std::copy(pixels.row(y) + x0, pixels.row(y) + x1 + 1, dst.row(y) + x0);
+    }
+};
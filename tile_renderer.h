@@ -0,0 +1,271 @@
+// tile_renderer.h
+// Tiled, multi-threaded rasterization of a 2D frame into a CPU framebuffer.
+//
+// A frame is first recorded: every primitive (disc, circle outline, line, thick line,
+// dashed line, rectangle, bubble sprite) is appended to a command list in draw order and binned into
+// the screen tiles its bounding box touches. render() then splits the requested
+// rectangles (the whole screen, or the dirty regions) into one job per tile, and the jobs
+// run on a WorkStealingPool: each copies its rectangle from the background layer and
+// replays its tile's commands, in order, through the clipped raster kernels. Those emit
+// exactly the unclipped kernels' pixels inside the rectangle and jobs never overlap, so
+// the result is pixel-identical to drawing the commands one after another on one thread.
+//
+// A bubble is usually larger than a tile, and clipping the midpoint kernels to a tile
+// still walks the whole circle, so discs and outlines are drawn from a per-radius row
+// profile instead: the disc's half-width and the outline's run on each row, taken from the
+// kernels' own output when the radius is first recorded. A tile then touches only its own
+// rows. DDA lines are rasterized once while recording and their pixels binned as one run
+// per tile, so a tile replays only the pixels that fall in it. Thick lines are turned
+// into their row spans once while recording too; a tile finds its first row by binary search.
+
+#pragma once
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "dirty_rects.h"
+#include "framebuffer.h"
+#include "raster.h"
+#include "sprite_cache.h"
+#include "work_stealing_pool.h"
+
+// What fillCircleMidpoint and circleMidpoint draw on row yc +- dy, dy = 0..r: the disc
+// spans [-discHalf, discHalf] and the outline covers [ringIn, ringOut] and its mirror
+// [-ringOut, -ringIn] (the midpoint outline is one run per side on every row)
+struct CircleRows {
+    std::vector<int> discHalf, ringIn, ringOut;
+
+    explicit CircleRows(int r) : discHalf(r + 1, -1), ringIn(r + 1, r + 1), ringOut(r + 1, -1) {
+        struct Recorder {
+            CircleRows& rows;
+            void plot(int x, int y) {
+                if (x < 0 || y < 0) return; // mirrored
+                rows.ringIn[y] = std::min(rows.ringIn[y], x);
+                rows.ringOut[y] = std::max(rows.ringOut[y], x);
+            }
+            void span(int, int x1, int y) {
+                if (y >= 0) rows.discHalf[y] = x1;
+            }
+        } recorder{ *this };
+        raster::fillCircleMidpoint(recorder, 0, 0, r);
+        raster::circleMidpoint(recorder, 0, 0, r);
+    }
+};
+
+struct TileCommand {
+    enum Kind : uint8_t { DISC, CIRCLE, LINE, RECT, SPRITE, POINTS, SPANS };
+    Kind kind;
+    uint32_t color;
+    int a, b, c, d;                // DISC / CIRCLE: xc, yc, r; LINE / RECT: x0, y0, x1, y1;
+                                   // POINTS: [a, b) into points; SPANS: [a, b) into spans
+    const BubbleSprite* sprite;    // SPRITE: drawn centered on (a, b)
+    BubblePalette palette;         // SPRITE
+    const CircleRows* rows;        // DISC / CIRCLE
+};
+
+struct TileRenderer {
+    static constexpr int TILE = 128;
+
+    int width = 0, height = 0;
+    int cols = 0, rows = 0;
+    std::vector<TileCommand> commands;
+    std::vector<raster::Point> points;       // pixels of the recorded DDA lines
+    struct Span {
+        int x0, x1, y;
+    };
+    std::vector<Span> spans;                 // rows of the recorded thick lines, each line's in increasing y
+    std::vector<std::vector<uint32_t>> bins; // command indices per tile, in draw order
+    struct Job {
+        int tile;
+        raster::ClipRect rect;
+    };
+    std::vector<Job> jobs;
+    WorkStealingPool pool;
+    std::unordered_map<int, std::unique_ptr<CircleRows>> circleRows; // by radius, kept across frames
+
+    // start recording a frame for a width x height target
+    void begin(int w, int h) {
+        if (w != width || h != height) {
+            width = w;
+            height = h;
+            cols = (w + TILE - 1) / TILE;
+            rows = (h + TILE - 1) / TILE;
+            bins.assign((size_t)cols * rows, {});
+        }
+        for (auto& bin : bins) bin.clear();
+        commands.clear();
+        points.clear();
+        spans.clear();
+    }
+
+    void disc(int xc, int yc, int r, uint32_t color) {
+        if (r >= 0) add({ TileCommand::DISC, color, xc, yc, r, 0, nullptr, {}, &rowsFor(r) }, xc - r, yc - r, xc + r, yc + r);
+    }
+
+    void circle(int xc, int yc, int r, uint32_t color) {
+        if (r >= 0) add({ TileCommand::CIRCLE, color, xc, yc, r, 0, nullptr, {}, &rowsFor(r) }, xc - r, yc - r, xc + r, yc + r);
+    }
+
+    void lineBresenham(int x0, int y0, int x1, int y1, uint32_t color) {
+        add({ TileCommand::LINE, color, x0, y0, x1, y1, nullptr, {}, nullptr },
+            std::min(x0, x1), std::min(y0, y1), std::max(x0, x1), std::max(y0, y1));
+    }
+
+    void thickLine(int x0, int y0, int x1, int y1, float width, raster::LineCap cap, uint32_t color) {
+        const int first = (int)spans.size();
+        int left = INT_MAX, right = -1, yMin = -1, yMax = -1;
+        raster::thickLineSpans(x0, y0, x1, y1, width, cap, [&](int a, int b, int y) {
+            if (spans.size() == (size_t)first) yMin = y; // rows arrive in increasing y
+            yMax = y;
+            left = std::min(left, a);
+            right = std::max(right, b);
+            spans.push_back({ a, b, y });
+        });
+        if ((int)spans.size() > first)
+            add({ TileCommand::SPANS, color, first, (int)spans.size(), 0, 0, nullptr, {}, nullptr }, left, yMin, right, yMax);
+    }
+
+    void rect(int x0, int y0, int x1, int y1, uint32_t color) {
+        if (x0 <= x1 && y0 <= y1) add({ TileCommand::RECT, color, x0, y0, x1, y1, nullptr, {}, nullptr }, x0, y0, x1, y1);
+    }
+
+    // the sprite must stay alive until render() returns (see BubbleSpriteCache::holdEvictions)
+    void sprite(const BubbleSprite& s, int xc, int yc, const BubblePalette& p) {
+        const int e = s.extent;
+        add({ TileCommand::SPRITE, 0, xc, yc, 0, 0, &s, p, nullptr }, xc - e, yc - e, xc + e, yc + e);
+    }
+
+    void lineDDA(int x0, int y0, int x1, int y1, uint32_t color) {
+        size_t first = points.size();
+        raster::ClipStats unused;
+        raster::lineDDAFixedClipped(PointSink{ points }, screen(), unused, x0, y0, x1, y1);
+        addPointRuns(first, color);
+    }
+
+    void dashedLineDDA(int x0, int y0, int x1, int y1, int dashLen, uint32_t color) {
+        size_t first = points.size();
+        raster::ClipStats unused;
+        raster::dashedLineDDAFixedClipped(PointSink{ points }, screen(), unused, x0, y0, x1, y1, dashLen);
+        addPointRuns(first, color);
+    }
+
+    // Rasterize the recorded frame into fb (width x height, clip rectangle reset), only
+    // inside the given disjoint rectangles, each first restored from background when set
+    void render(Framebuffer& fb, const Framebuffer* background, const std::vector<IRect>& rects) {
+        jobs.clear();
+        for (const IRect& r : rects) {
+            int x0 = std::max(r.x0, 0), y0 = std::max(r.y0, 0);
+            int x1 = std::min(r.x1, width - 1), y1 = std::min(r.y1, height - 1);
+            if (x0 > x1 || y0 > y1) continue;
+            for (int ty = y0 / TILE; ty <= y1 / TILE; ++ty)
+                for (int tx = x0 / TILE; tx <= x1 / TILE; ++tx)
+                    jobs.push_back({ ty * cols + tx, { std::max(x0, tx * TILE), std::max(y0, ty * TILE),
+                        std::min(x1, tx * TILE + TILE - 1), std::min(y1, ty * TILE + TILE - 1) } });
+        }
+        pool.run((int)jobs.size(), [&](int j, int) { rasterizeJob(fb, background, jobs[j]); });
+    }
+
+private:
+    struct PointSink {
+        std::vector<raster::Point>& out;
+        void plot(int x, int y) { out.push_back({ x, y }); }
+        void span(int x0, int x1, int y) {
+            for (int x = x0; x <= x1; ++x) out.push_back({ x, y });
+        }
+    };
+
+    const CircleRows& rowsFor(int r) {
+        std::unique_ptr<CircleRows>& rows = circleRows[r];
+        if (!rows) rows = std::make_unique<CircleRows>(r);
+        return *rows;
+    }
+
+    static void fillRow(Framebuffer& fb, const raster::ClipRect& c, int x0, int x1, int y, uint32_t color) {
+        x0 = std::max(x0, c.x0);
+        x1 = std::min(x1, c.x1);
+        if (x0 <= x1) std::fill_n(fb.row(y) + x0, x1 - x0 + 1, color);
+    }
+
+    raster::ClipRect screen() const { return { 0, 0, width - 1, height - 1 }; }
+
+    void add(const TileCommand& cmd, int x0, int y0, int x1, int y1) {
+        x0 = std::max(x0, 0); y0 = std::max(y0, 0);
+        x1 = std::min(x1, width - 1); y1 = std::min(y1, height - 1);
+        if (x0 > x1 || y0 > y1) return;
+        const uint32_t index = (uint32_t)commands.size();
+        commands.push_back(cmd);
+        for (int ty = y0 / TILE; ty <= y1 / TILE; ++ty)
+            for (int tx = x0 / TILE; tx <= x1 / TILE; ++tx) bins[(size_t)ty * cols + tx].push_back(index);
+    }
+
+    // bin points[first..] as one POINTS command per run of consecutive pixels in one tile
+    void addPointRuns(size_t first, uint32_t color) {
+        size_t i = first;
+        while (i < points.size()) {
+            const int tile = tileOf(points[i]);
+            size_t j = i + 1;
+            while (j < points.size() && tileOf(points[j]) == tile) ++j;
+            bins[tile].push_back((uint32_t)commands.size());
+            commands.push_back({ TileCommand::POINTS, color, (int)i, (int)j, 0, 0, nullptr, {}, nullptr });
+            i = j;
+        }
+    }
+
+    int tileOf(const raster::Point& p) const { return (p.y / TILE) * cols + p.x / TILE; }
+
+    void rasterizeJob(Framebuffer& fb, const Framebuffer* background, const Job& job) {
+        const raster::ClipRect& c = job.rect;
+        if (background)
+            for (int y = c.y0; y <= c.y1; ++y)
+                std::copy(background->row(y) + c.x0, background->row(y) + c.x1 + 1, fb.row(y) + c.x0);
+        raster::ClipStats unused; // tile edges are not viewport clipping
+        for (uint32_t index : bins[job.tile]) {
+            const TileCommand& cmd = commands[index];
+            raster::FramebufferSink sink{ fb, cmd.color };
+            switch (cmd.kind) {
+            case TileCommand::DISC: {
+                const int xc = cmd.a, yc = cmd.b, r = cmd.c;
+                const int* half = cmd.rows->discHalf.data();
+                const uint32_t color = cmd.color;
+                const int y1 = std::min(c.y1, yc + r);
+                for (int y = std::max(c.y0, yc - r); y <= y1; ++y) {
+                    const int h = half[std::abs(y - yc)];
+                    fillRow(fb, c, xc - h, xc + h, y, color);
+                }
+                break;
+            }
+            case TileCommand::CIRCLE: {
+                const int xc = cmd.a, yc = cmd.b, r = cmd.c;
+                const int* in = cmd.rows->ringIn.data();
+                const int* outer = cmd.rows->ringOut.data();
+                const uint32_t color = cmd.color;
+                const int y1 = std::min(c.y1, yc + r);
+                for (int y = std::max(c.y0, yc - r); y <= y1; ++y) {
+                    const int dy = std::abs(y - yc);
+                    fillRow(fb, c, xc - outer[dy], xc - in[dy], y, color);
+                    fillRow(fb, c, xc + in[dy], xc + outer[dy], y, color);
+                }
+                break;
+            }
+            case TileCommand::LINE: raster::lineBresenhamClipped(sink, c, unused, cmd.a, cmd.b, cmd.c, cmd.d); break;
+            case TileCommand::RECT: raster::fillRectClipped(sink, c, unused, cmd.a, cmd.b, cmd.c, cmd.d); break;
+            case TileCommand::SPRITE: blitSprite(fb, *cmd.sprite, cmd.a, cmd.b, cmd.palette, c); break;
+            case TileCommand::POINTS:
+                for (int i = cmd.a; i < cmd.b; ++i)
+                    if (c.contains(points[i].x, points[i].y)) fb.row(points[i].y)[points[i].x] = cmd.color;
+                break;
+            case TileCommand::SPANS: {
+                const Span* first = spans.data() + cmd.a;
+                const Span* end = spans.data() + cmd.b;
+                const Span* s = std::lower_bound(first, end, c.y0, [](const Span& s, int y) { return s.y < y; });
+                for (; s != end && s->y <= c.y1; ++s) fillRow(fb, c, s->x0, s->x1, s->y, cmd.color);
+                break;
+            }
+            }
+        }
+    }
+};
@@ -0,0 +1,43 @@
+// triple_buffer.h
+// Lock-free single-producer / single-consumer triple buffer for handing whole snapshots from
+// one thread to another.
+//
+// The producer always owns one slot (writeBuffer) and the consumer one (readBuffer); the
+// third slot sits in the middle. publish() swaps the producer's slot with the middle one and
+// marks it fresh; acquire() swaps the consumer's slot with the middle one only if it is
+// fresh. Neither side ever waits for the other: a slow consumer just skips snapshots, and a
+// slow producer leaves the consumer re-reading the last one. A slot is never touched by both
+// threads at once, so the snapshot type needs no synchronization of its own, and its
+// containers keep their capacity as the slots rotate.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+template <class T>
+struct TripleBuffer {
+    static constexpr uint8_t INDEX_MASK = 3;
+    static constexpr uint8_t FRESH = 4; // middle slot holds a snapshot the consumer has not seen
+
+    T slots[3];
+    std::atomic<uint8_t> middle{ 1 };
+    uint8_t back = 0;  // producer only
+    uint8_t front = 2; // consumer only
+
+    // producer: fill this, then publish()
+    T& writeBuffer() { return slots[back]; }
+
+    void publish() {
+        back = middle.exchange((uint8_t)(back | FRESH), std::memory_order_acq_rel) & INDEX_MASK;
+    }
+
+    // consumer: take the newest published snapshot, if any; returns false when nothing new
+    bool acquire() {
+        if (!(middle.load(std::memory_order_relaxed) & FRESH)) return false;
+        front = middle.exchange(front, std::memory_order_acq_rel) & INDEX_MASK;
+        return true;
+    }
+
+    const T& readBuffer() const { return slots[front]; }
+};
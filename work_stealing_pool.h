@@ -0,0 +1,140 @@
+// work_stealing_pool.h
+// Fixed-size thread pool that runs batches of independent tasks with work stealing.
+//
+// run(count, task) splits [0, count) into one contiguous block per thread. Each thread
+// takes tasks from the front of its own block; a thread whose block is empty steals single
+// tasks from the back of another's, so uneven tasks (a tile full of bubbles next to an
+// empty one) even out without a shared queue every task has to go through. The calling
+// thread works on block 0 and run() returns once every task has finished and every worker
+// has left the batch, so the task may reference the caller's stack.
+//
+// Blocks are guarded by one small mutex each; tasks are meant to be coarse (tens of
+// microseconds and up), where a lock per task is noise.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class WorkStealingPool {
+public:
+    // total threads taking part in a batch, the caller included (at least 1)
+    explicit WorkStealingPool(int threads = 1) { resize(threads); }
+
+    ~WorkStealingPool() { stopWorkers(); }
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    int threads() const { return (int)blocks.size(); }
+
+    void resize(int threads) {
+        threads = std::max(1, threads);
+        if (threads == (int)blocks.size()) return;
+        stopWorkers();
+        blocks.clear();
+        for (int i = 0; i < threads; ++i) blocks.push_back(std::make_unique<Block>());
+        stop = false;
+        // new workers wait for the next batch, not one that already ran
+        for (int i = 1; i < threads; ++i) workers.emplace_back([this, i, g = generation] { workerLoop(i, g); });
+    }
+
+    // Run task(index, thread) for every index in [0, count); thread is the 0-based slot of
+    // the thread running it (0 = the caller), e.g. for per-thread scratch state
+    void run(int count, const std::function<void(int, int)>& task) {
+        if (count <= 0) return;
+        const int n = threads();
+        for (int i = 0; i < n; ++i) {
+            blocks[i]->begin = (int)((int64_t)count * i / n);
+            blocks[i]->end = (int)((int64_t)count * (i + 1) / n);
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            current = &task;
+            busyWorkers = n - 1;
+            ++generation;
+        }
+        wake.notify_all();
+        work(0);
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return busyWorkers == 0; });
+        current = nullptr;
+    }
+
+    // tasks taken from another thread's block since construction
+    uint64_t steals() const { return stolen.load(std::memory_order_relaxed); }
+
+private:
+    struct Block {
+        std::mutex m;
+        int begin = 0, end = 0; // tasks not taken yet
+    };
+
+    std::vector<std::unique_ptr<Block>> blocks;
+    std::vector<std::thread> workers;
+    std::mutex mutex; // guards current, generation, busyWorkers, stop
+    std::condition_variable wake, done;
+    const std::function<void(int, int)>* current = nullptr;
+    uint64_t generation = 0;
+    int busyWorkers = 0;
+    bool stop = false;
+    std::atomic<uint64_t> stolen{ 0 };
+
+    bool takeOwn(int self, int& task) {
+        Block& b = *blocks[self];
+        std::lock_guard<std::mutex> lock(b.m);
+        if (b.begin >= b.end) return false;
+        task = b.begin++;
+        return true;
+    }
+
+    bool steal(int self, int& task) {
+        const int n = threads();
+        for (int k = 1; k < n; ++k) {
+            Block& b = *blocks[(self + k) % n];
+            std::lock_guard<std::mutex> lock(b.m);
+            if (b.begin < b.end) {
+                task = --b.end;
+                stolen.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void work(int self) {
+        int task;
+        while (takeOwn(self, task) || steal(self, task)) (*current)(task, self);
+    }
+
+    void workerLoop(int self, uint64_t seen) {
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&] { return stop || generation != seen; });
+                if (stop) return;
+                seen = generation;
+            }
+            work(self);
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--busyWorkers == 0) done.notify_one();
+        }
+    }
+
+    void stopWorkers() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        wake.notify_all();
+        for (std::thread& t : workers) t.join();
+        workers.clear();
+    }
+};